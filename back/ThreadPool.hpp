@@ -3,135 +3,420 @@
 
 #include <iostream>
 #include <vector>
-#include <queue>
+#include <memory>
 #include <functional>
-#include <mutex>
-#include <condition_variable>
+#include <future>
+#include <type_traits>
 #include <atomic>
+#include <cstdint>
+#include <chrono>
 #include <pthread.h>  // Incluir a biblioteca pthread
+#include <sched.h>
+#include "work_stealing_deque.hpp"
+#include "mpmc_queue.hpp"
+#include "topology.hpp"
 
 using namespace std;
 
+// Quantidade de rodadas de busca (com uma pausa curta da CPU entre elas) antes de começar a ceder a CPU
+#define THREADPOOL_PAUSE_ROUNDS 32
+
+// Quantidade de rodadas de busca (com sched_yield entre elas) antes de uma thread ociosa dormir
+#define THREADPOOL_SPIN_ROUNDS 64
+
+// Quantidade máxima de threads do pool (inclusive depois de `resize`)
+#define THREADPOOL_MAX_THREADS 256
+
+// Capacidade da fila de injeção (tarefas adicionadas de fora do pool e ainda não retiradas)
+#define THREADPOOL_INJECTION_CAPACITY 4096
+
+// Tempo máximo, em milissegundos, que uma classe de prioridade com tarefas esperando fica sem ser atendida
+// (envelhecimento: depois disso, a próxima thread livre atende essa classe antes das de prioridade maior)
+#define THREADPOOL_AGING_MS 25
+
+/*
+    * Classes de prioridade das tarefas, da maior para a menor.
+    * INTERACTIVE: pedidos de um usuário esperando o resultado na tela;
+    * NORMAL: prioridade padrão;
+    * BATCH: processamentos em lote, que podem esperar.
+*/
+enum class TaskPriority {
+    INTERACTIVE = 0,
+    NORMAL = 1,
+    BATCH = 2
+};
+
+// Quantidade de classes de prioridade
+#define THREADPOOL_PRIORITY_CLASSES 3
+
+/*
+    * Atraso de fila de uma classe de prioridade: o tempo entre uma tarefa ser adicionada e começar a rodar.
+*/
+typedef struct QueueDelayStats {
+    int64_t tasks;
+    double mean_ms;
+    double max_ms;
+} QueueDelayStats;
+
+// Pausa curta dentro de um laço de espera ativa (instrução `pause` em x86)
+static inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
 /*
     * Classe ThreadPool
     *
-    * Esta classe implementa um pool de threads que pode ser usado para executar tarefas em paralelo.
-    * O pool de threads é inicializado com um número fixo de threads, e as tarefas podem ser adicionadas a uma fila.
-    * As threads retiram as tarefas da fila e as executam. O pool pode ser parado quando não for mais necessário.
+    * Esta classe implementa um pool de threads com roubo de tarefas (work stealing), que pode ser usado para executar tarefas em paralelo.
+    * O pool de threads é inicializado com um número de threads, que pode ser mudado depois com `resize`,
+    * e as tarefas podem ser adicionadas com `enqueue`.
+    *
+    * Cada thread tem a sua própria deque de tarefas (Chase-Lev). Tarefas criadas por uma thread do pool vão para a deque
+    * dela, sem lock. Tarefas criadas fora do pool (ex.: pelo servidor) vão para uma fila global de injeção,
+    * também sem lock (fila circular limitada de Vyukov), uma fila por classe de prioridade.
+    * Uma thread sem tarefas procura, nessa ordem: na própria deque, nas filas de injeção (da maior prioridade para
+    * a menor) e, por fim, rouba do topo da deque de outra thread, escolhida aleatoriamente.
+    * Só depois de algumas rodadas sem achar nada ela dorme.
+    * Uma tarefa da própria deque só passa na frente se nenhuma fila de injeção de prioridade maior tiver tarefas, e uma classe
+    * com tarefas esperando há mais de THREADPOOL_AGING_MS é atendida antes das outras (envelhecimento), para nunca ficar parada.
+    * Opcionalmente, cada thread é fixada (pinned) em uma CPU, seguindo a topologia lida do sysfs, e passa a ter um nó NUMA fixo.
+    * O pool pode ser parado quando não for mais necessário.
 */
 class ThreadPool {
     private:
+        /*
+         * Tarefa do pool: a função, a classe de prioridade e o instante em que foi adicionada
+         * (em nanossegundos do steady_clock, para medir o atraso de fila).
+        */
+        struct Task {
+            function<void()> run;
+            TaskPriority priority;
+            int64_t enqueued_at;
+        };
+
+        /*
+         * Fila de injeção de uma classe de prioridade e as medidas dela.
+         * `queued` conta as tarefas na fila, e `served_at`, o instante em que a classe foi atendida pela última vez
+         * (ou em que passou a ter tarefas esperando), usado no envelhecimento.
+        */
+        struct PriorityClass {
+            BoundedMpmcQueue<Task*> injection{THREADPOOL_INJECTION_CAPACITY};
+            alignas(64) atomic<int64_t> queued{0};
+            atomic<int64_t> served_at{0};
+
+            // Atraso de fila das tarefas da classe já iniciadas: quantidade, soma e máximo (em nanossegundos)
+            alignas(64) atomic<int64_t> started{0};
+            atomic<int64_t> total_delay{0};
+            atomic<int64_t> max_delay{0};
+        };
+
+        /*
+         * Estado de cada thread do pool: a thread do sistema operacional, a deque de tarefas,
+         * o gerador de números aleatórios usado para escolher de quem roubar, a CPU em que a thread foi fixada
+         * (-1 se não foi fixada) e a prioridade da tarefa que ela está executando (herdada pelas tarefas criadas nela).
+         * `exited` indica que a thread saiu por ter sido removida com `resize` (protegido por `mtx`),
+         * e `joined`, que ela já foi esperada com pthread_join (protegido por `resize_mtx`).
+        */
+        struct Worker {
+            pthread_t thread;
+            ThreadPool* pool;
+            int index;
+            int cpu;
+            int node;
+            uint32_t random_state;
+            TaskPriority running;
+            bool exited;
+            bool joined;
+            WorkStealingDeque<Task> tasks;
+        };
+
+        /*
+         * Worker da thread atual (nullptr se a thread não pertence a nenhum pool).
+         * Usado por `enqueue` para decidir entre a deque local e a fila de injeção.
+        */
+        inline static thread_local Worker* current_worker = nullptr;
 
         /**
          * Variável para indicar se as threads devem parar ou não.
          *
-         * - `true`: as threads devem parar de processar tarefas e sair. 
+         * - `true`: as threads devem parar de processar tarefas e sair.
          * - `false`: as threads continuam processando tarefas normalmente.
         */
-        bool stop;
+        atomic<bool> stop;
 
         /*
-         * Vetor de threads que compõem o pool de threads.
+         * Vetor com as threads que compõem o pool de threads, cada uma com a sua deque de tarefas.
          *
-         * Cada thread no vetor é uma instância da classe `pthread_t`, que representa uma thread do sistema operacional.
+         * Tem tamanho fixo (THREADPOOL_MAX_THREADS), para nunca ser realocado enquanto outras threads roubam dele.
+         * `created` é a quantidade de posições já preenchidas, e `active`, a quantidade de threads em uso:
+         * as threads com índice maior ou igual a `active` terminam as tarefas da própria deque e saem.
         */
-        vector<pthread_t> threads;
+        unique_ptr<unique_ptr<Worker>[]> workers;
+        atomic<int> created;
+        atomic<int> active;
+
+        // Se as threads são fixadas em CPUs, e a ordem das CPUs usadas
+        bool pin_threads;
+        vector<int> placement;
+
+        // Serializa `resize` e `stop_all_threads`
+        pthread_mutex_t resize_mtx = PTHREAD_MUTEX_INITIALIZER;
 
         /*
-         * Fila de tarefas a serem executadas pelas threads do pool.
+         * Filas globais de injeção, com as tarefas adicionadas de fora do pool, uma por classe de prioridade.
          *
-         * Cada tarefa é uma função que não recebe parâmetros e não retorna valor (`function<void()>`).
-         * As threads retiram tarefas dessa fila para processá-las.
+         * São limitadas: se uma estiver cheia, quem adiciona espera (cedendo a CPU) até as threads retirarem alguma tarefa.
         */
-        queue<function<void()>> tasks;
+        PriorityClass classes[THREADPOOL_PRIORITY_CLASSES];
 
         /*
-         * Mutex para proteger o acesso à fila de tarefas.
-         *
-         * Garante que apenas uma thread possa acessar a fila de tarefas ao mesmo tempo, evitando condições de corrida.
+         * Quantidade de tarefas adicionadas e ainda não iniciadas (em qualquer deque ou na fila de injeção).
+         * Uma thread só dorme se esse contador estiver zerado.
         */
-        pthread_mutex_t mtx = PTHREAD_MUTEX_INITIALIZER;
+        atomic<int64_t> pending;
+
+        // Quantidade de tarefas sendo executadas agora
+        atomic<int> busy;
 
         /*
-         * Variável de condição para notificar as threads quando uma nova tarefa é adicionada à fila.
-         *
-         * As threads aguardam nessa variável de condição até que uma nova tarefa esteja disponível.
+         * Mutex e variável de condição usados apenas para as threads ociosas dormirem e serem acordadas.
+         * `sleeping` conta as threads dormindo, para que `enqueue` só sinalize quando houver alguém para acordar.
         */
+        pthread_mutex_t mtx = PTHREAD_MUTEX_INITIALIZER;
         pthread_cond_t cond_var = PTHREAD_COND_INITIALIZER;
+        atomic<int> sleeping;
+
+        static int64_t now() {
+            return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        // Retira a próxima tarefa da fila de injeção de uma classe (nullptr se estiver vazia)
+        Task* pop_class(int priority, int64_t time) {
+            PriorityClass& c = classes[priority];
+            if (c.queued.load(memory_order_acquire) <= 0) return nullptr;
 
+            Task* task = nullptr;
+            if (!c.injection.try_pop(task)) return nullptr;
+            c.queued.fetch_sub(1, memory_order_acq_rel);
+            c.served_at.store(time, memory_order_relaxed);
+            return task;
+        }
+
+        /*
+         * Retira a próxima tarefa das filas de injeção.
+         * Primeiro as classes de prioridade menor que estão sem ser atendidas há mais de THREADPOOL_AGING_MS
+         * (a que espera há mais tempo antes), depois as classes em ordem de prioridade.
+         * @returns: a tarefa, ou nullptr se todas as filas estiverem vazias
+        */
+        Task* pop_injection() {
+            int64_t time = now();
+            int64_t aging = THREADPOOL_AGING_MS * 1000000LL;
+
+            for (int priority = THREADPOOL_PRIORITY_CLASSES - 1; priority > 0; priority--) {
+                const PriorityClass& c = classes[priority];
+                if (c.queued.load(memory_order_relaxed) > 0 && time - c.served_at.load(memory_order_relaxed) > aging) {
+                    if (Task* task = pop_class(priority, time)) return task;
+                }
+            }
+            for (int priority = 0; priority < THREADPOOL_PRIORITY_CLASSES; priority++) {
+                if (Task* task = pop_class(priority, time)) return task;
+            }
+            return nullptr;
+        }
+
+        // Maior prioridade (menor número) com tarefas na fila de injeção, ou THREADPOOL_PRIORITY_CLASSES se todas estiverem vazias
+        int highest_waiting_class() const {
+            for (int priority = 0; priority < THREADPOOL_PRIORITY_CLASSES; priority++) {
+                if (classes[priority].queued.load(memory_order_relaxed) > 0) return priority;
+            }
+            return THREADPOOL_PRIORITY_CLASSES;
+        }
+
+        // Registra o atraso de fila de uma tarefa que vai começar
+        void record_delay(const Task* task) {
+            PriorityClass& c = classes[(int) task->priority];
+            int64_t delay = max<int64_t>(0, now() - task->enqueued_at);
+            c.started.fetch_add(1, memory_order_relaxed);
+            c.total_delay.fetch_add(delay, memory_order_relaxed);
+            int64_t previous = c.max_delay.load(memory_order_relaxed);
+            while (previous < delay && !c.max_delay.compare_exchange_weak(previous, delay, memory_order_relaxed)) {}
+        }
+
+        // Tenta roubar uma tarefa de outra thread, começando por uma vítima aleatória
+        Task* steal(Worker* self) {
+            int n = created.load(memory_order_acquire);
+            if (n <= 1) return nullptr;
+
+            // xorshift32
+            uint32_t x = self->random_state;
+            x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+            self->random_state = x;
+
+            int start = x % n;
+            for (int i = 0; i < n; i++) {
+                Worker* victim = workers[(start + i) % n].get();
+                if (victim == self) continue;
+                if (Task* task = victim->tasks.steal()) return task;
+            }
+            return nullptr;
+        }
+
+        // Indica se a thread foi removida com `resize` e deve sair quando a própria deque esvaziar
+        bool retiring(const Worker* self) const {
+            return self->index >= active.load(memory_order_acquire);
+        }
+
+        // Procura uma tarefa: na própria deque, nas filas de injeção e nas deques das outras threads
+        // A tarefa da própria deque volta para ela se houver tarefas de prioridade maior na injeção
+        // Uma thread sendo removida só esvazia a própria deque
+        Task* find_task(Worker* self) {
+            Task* task = self->tasks.pop();
+            if (task && !retiring(self) && (int) task->priority > highest_waiting_class()) {
+                self->tasks.push(task);
+                task = nullptr;
+            }
+            if (!task && !retiring(self)) task = pop_injection();
+            if (!task && !retiring(self)) task = self->tasks.pop();
+            if (!task && !retiring(self)) task = steal(self);
+            if (task) {
+                pending.fetch_sub(1, memory_order_seq_cst);
+                record_delay(task);
+            }
+            return task;
+        }
 
         /*
          * Função que será executada por cada thread do pool.
          *
-         * Essa função fica em loop, aguardando novas tarefas na fila. Quando uma tarefa é adicionada, a thread a executa.
-         * Se `stop` for verdadeiro e a fila estiver vazia, a thread sai do loop e termina sua execução
-         * 
-         * @param arg Ponteiro para o objeto `ThreadPool` que contém a fila de tarefas e outras informações necessárias.
+         * Essa função fica em loop procurando tarefas e executando-as. Sem tarefas, a thread tenta mais algumas
+         * rodadas, primeiro só com uma pausa curta da CPU, depois cedendo a CPU entre elas, e então dorme na
+         * variável de condição até que uma tarefa seja adicionada.
+         * Se `stop` for verdadeiro e não houver mais tarefas, a thread sai do loop e termina sua execução.
+         * Uma thread removida com `resize` também sai, assim que não sobrar nada na própria deque.
+         *
+         * @param arg Ponteiro para o `Worker` da thread
          * @return `nullptr` quando a thread termina sua execução
         */
         static void* thread_function(void* arg) {
-            // Converte o argumento recebido para um ponteiro do tipo ThreadPool
-            ThreadPool* pool = static_cast<ThreadPool*>(arg);
+            Worker* self = static_cast<Worker*>(arg);
+            ThreadPool* pool = self->pool;
+            current_worker = self;
 
             // Loop infinito para processar tarefas
-            while(true) {
-                // Variável para armazenar a tarefa a ser executada
-                function<void()> task;
+            while (true) {
+                Task* task = pool->find_task(self);
 
-                // Lock para pegar a tarefa da fila
-                pthread_mutex_lock(&pool->mtx);
+                // Sem tarefas: tenta mais algumas vezes antes de dormir
+                for (int round = 0; !task && !pool->retiring(self) && round < THREADPOOL_PAUSE_ROUNDS; round++) {
+                    cpu_relax();
+                    task = pool->find_task(self);
+                }
+                for (int round = 0; !task && !pool->retiring(self) && round < THREADPOOL_SPIN_ROUNDS; round++) {
+                    sched_yield();
+                    task = pool->find_task(self);
+                }
 
-                // Enquanto não houver tarefas e stop for falso, espera pela notificação
-                while (!pool->stop && pool->tasks.empty()) {
-                    pthread_cond_wait(&pool->cond_var, &pool->mtx);
+                if (task) {
+                    // Executa a tarefa (as tarefas criadas por ela herdam a sua prioridade)
+                    self->running = task->priority;
+                    pool->busy.fetch_add(1, memory_order_relaxed);
+                    task->run();
+                    pool->busy.fetch_sub(1, memory_order_release);
+                    delete task;
+                    continue;
                 }
 
-                // Se stop for verdadeiro e a fila estiver vazia, sai da thread
-                if (pool->stop && pool->tasks.empty()) {
+                // Removida com `resize`: sai da thread (decidido sob o mutex, para que `resize` saiba se ela ainda está rodando)
+                pthread_mutex_lock(&pool->mtx);
+                if (pool->retiring(self)) {
+                    self->exited = true;
                     pthread_mutex_unlock(&pool->mtx);
                     return nullptr;
                 }
 
-                // Se houver tarefas, pega a primeira tarefa da fila, removendo-a da fila
-                task = move(pool->tasks.front());
-                pool->tasks.pop();
+                // Dorme até que uma tarefa seja adicionada (ou o pool seja parado ou diminuído)
+                pool->sleeping.fetch_add(1, memory_order_seq_cst);
+                while (!pool->stop.load() && pool->pending.load(memory_order_seq_cst) <= 0 && !pool->retiring(self)) {
+                    pthread_cond_wait(&pool->cond_var, &pool->mtx);
+                }
+                pool->sleeping.fetch_sub(1, memory_order_seq_cst);
 
-                // Libera o lock para permitir que outras threads acessem a fila
+                // Se stop for verdadeiro e não houver mais tarefas, sai da thread
+                bool finished = pool->stop.load() && pool->pending.load() <= 0;
                 pthread_mutex_unlock(&pool->mtx);
-
-                // Executa a tarefa
-                task();
+                if (finished) {
+                    return nullptr;
+                }
             }
 
             // Retorna nullptr quando a thread termina
             return nullptr;
         }
 
+        /*
+         * Cria (ou reaproveita) o worker da posição `index` e inicia a thread dele.
+         * Deve ser chamada com `resize_mtx` travado, depois de `active` já incluir a posição.
+         * @param index Posição do worker
+        */
+        void start_worker(int index) {
+            if (index >= created.load(memory_order_relaxed)) {
+                const CpuTopology& topology = CpuTopology::instance();
+                auto worker = make_unique<Worker>();
+                worker->pool = this;
+                worker->index = index;
+                worker->cpu = placement.empty() ? -1 : placement[index % placement.size()];
+                worker->node = placement.empty() ? -1 : topology.node_of(worker->cpu);
+                worker->random_state = 2463534242u + 7919u * index;
+                worker->running = TaskPriority::NORMAL;
+                workers[index] = move(worker);
+
+                // Publica a nova posição para quem rouba
+                created.store(index + 1, memory_order_release);
+            }
+
+            Worker* worker = workers[index].get();
+            worker->exited = false;
+            worker->joined = false;
+
+            pthread_attr_t attr;
+            pthread_attr_init(&attr);
+
+            // Fixa a thread na CPU escolhida antes de ela começar, para que a pilha e a deque nasçam no nó certo
+            if (worker->cpu >= 0) {
+                cpu_set_t cpus;
+                CPU_ZERO(&cpus);
+                CPU_SET(worker->cpu, &cpus);
+                pthread_attr_setaffinity_np(&attr, sizeof(cpus), &cpus);
+            }
+
+            // Criando threads com pthread_create
+            if (pthread_create(&worker->thread, &attr, thread_function, worker) != 0) {
+                cerr << "Erro ao criar thread!" << endl;
+                exit(1);
+            }
+            pthread_attr_destroy(&attr);
+        }
+
     public:
-        /*  
+        /*
          * Construtor da classe ThreadPool.
          *
          * Inicializa o pool de threads com o número especificado de threads.
-         * Cada thread é criada e adicionada ao vetor de threads.
+         * Cada thread é criada com a sua deque de tarefas e adicionada ao vetor de threads.
+         * Se `pin_threads` for verdadeiro, a thread i é fixada na i-ésima CPU de `CpuTopology::placement()`
+         * (uma por núcleo físico primeiro, nó por nó), voltando ao início se houver mais threads que CPUs.
          *
          * @param num_threads Número de threads a serem criadas no pool
-        
+         * @param pin_threads Se as threads devem ser fixadas em CPUs
         */
-        ThreadPool(int num_threads) : stop(false) {
-
-            for (int i = 0; i < num_threads; ++i) {
-                // Inicializa o vetor de threads com o número de threads especificado
-                pthread_t thread;
-
-                // Criando threads com pthread_create
-                if (pthread_create(&thread, nullptr, thread_function, this) != 0) {
-                    cerr << "Erro ao criar thread!" << endl;
-                    exit(1);
-                }
-
-                // Adiciona a thread criada ao vetor de threads
-                threads.push_back(thread);
-            }
+        ThreadPool(int num_threads, bool pin_threads = false)
+            : stop(false), workers(new unique_ptr<Worker>[THREADPOOL_MAX_THREADS]), created(0), active(0),
+              pin_threads(pin_threads), pending(0), busy(0), sleeping(0) {
+            if (pin_threads) placement = CpuTopology::instance().placement();
+            resize(num_threads);
         }
 
         /*
@@ -146,53 +431,245 @@ class ThreadPool {
         /*
          * Para todas as threads do pool, chama a função `stop_all_threads()` para parar e limpar as threads.
          *
+         * As threads terminam as tarefas que já estavam no pool antes de sair.
          * Essa função é chamada no destrutor da classe ThreadPool para garantir que todas as threads sejam paradas corretamente.
         */
         void stop_all_threads() {
-
-            // Lock para garantir que apenas uma thread acesse a variável stop ao mesmo tempo
-            pthread_mutex_lock(&mtx);
+            pthread_mutex_lock(&resize_mtx);
+            if (stop.load()) {
+                pthread_mutex_unlock(&resize_mtx);
+                return;
+            }
 
             // Define a variável stop como verdadeira, indicando que as threads devem parar
+            pthread_mutex_lock(&mtx);
             stop = true;
-
-            // Libera o lock para permitir que outras threads acessem a variável stop
             pthread_mutex_unlock(&mtx);
 
             // Notifica todas as threads para que elas possam sair do loop de espera
             pthread_cond_broadcast(&cond_var);
 
-            // Espera que todas as threads terminem sua execução
-            for (auto& thread : threads) {
-                pthread_join(thread, nullptr);
+            // Espera que todas as threads terminem sua execução (inclusive as removidas com `resize` ainda não esperadas)
+            int n = created.load();
+            for (int i = 0; i < n; i++) {
+                if (!workers[i]->joined) {
+                    pthread_join(workers[i]->thread, nullptr);
+                    workers[i]->joined = true;
+                }
             }
 
-            // Limpa a fila de tarefas para garantir que nenhuma tarefa incompleta continue
-            while (!tasks.empty()) {
-                tasks.pop();
+            // Limpa as filas de injeção para garantir que nenhuma tarefa incompleta continue
+            for (PriorityClass& c : classes) {
+                Task* task = nullptr;
+                while (c.injection.try_pop(task)) delete task;
+                c.queued = 0;
             }
 
-            // Limpa o vetor de threads
-            threads.clear();
+            // Nenhuma thread em uso
+            active = 0;
+            pthread_mutex_unlock(&resize_mtx);
         }
 
         /*
-         * Adiciona uma nova tarefa à fila de tarefas do pool.
+         * Muda a quantidade de threads do pool enquanto ele está em uso.
          *
-         * Essa função é chamada para adicionar uma nova tarefa que será executada por uma das threads do pool.
+         * Para aumentar, cria as threads que faltam (reaproveitando as posições de threads removidas antes).
+         * Para diminuir, marca as threads de índice maior como removidas e acorda todas: cada uma termina as tarefas
+         * da própria deque e sai, sem pegar tarefas novas. Elas são esperadas (pthread_join) depois, sem bloquear quem chamou.
          *
-         * @param task A tarefa a ser adicionada à fila. Deve ser uma função que não recebe parâmetros e não retorna valor.
+         * @param num_threads Nova quantidade de threads (entre 1 e THREADPOOL_MAX_THREADS)
         */
-        void enqueue(function<void()> task) {
-            // Lock para garantir que apenas uma thread acesse a fila de tarefas ao mesmo tempo
-            pthread_mutex_lock(&mtx);
+        void resize(int num_threads) {
+            num_threads = max(1, min(num_threads, THREADPOOL_MAX_THREADS));
 
-            // Adiciona a nova tarefa à fila de tarefas
-            tasks.push(move(task));
+            pthread_mutex_lock(&resize_mtx);
+            if (stop.load()) {
+                pthread_mutex_unlock(&resize_mtx);
+                return;
+            }
 
-            // Notifica uma thread para processar a tarefa
-            pthread_cond_signal(&cond_var);
-            pthread_mutex_unlock(&mtx);
+            int current = active.load();
+            if (num_threads > current) {
+                // Marca as novas posições como ativas e vê quais threads removidas ainda não saíram (essas continuam)
+                vector<int> to_start;
+                pthread_mutex_lock(&mtx);
+                active.store(num_threads, memory_order_release);
+                for (int i = current; i < num_threads; i++) {
+                    if (i >= created.load() || workers[i]->exited || workers[i]->joined) to_start.push_back(i);
+                }
+                pthread_mutex_unlock(&mtx);
+
+                for (int i : to_start) {
+                    if (i < created.load() && !workers[i]->joined) pthread_join(workers[i]->thread, nullptr);
+                    start_worker(i);
+                }
+            } else if (num_threads < current) {
+                pthread_mutex_lock(&mtx);
+                active.store(num_threads, memory_order_release);
+                pthread_mutex_unlock(&mtx);
+
+                // Acorda as threads dormindo, para que as removidas saiam
+                pthread_cond_broadcast(&cond_var);
+            }
+
+            // Espera as threads removidas que já saíram, para liberar os recursos delas
+            int n = created.load();
+            for (int i = num_threads; i < n; i++) {
+                pthread_mutex_lock(&mtx);
+                bool exited = workers[i]->exited;
+                pthread_mutex_unlock(&mtx);
+                if (exited && !workers[i]->joined) {
+                    pthread_join(workers[i]->thread, nullptr);
+                    workers[i]->joined = true;
+                }
+            }
+            pthread_mutex_unlock(&resize_mtx);
+        }
+
+        /*
+         * Adiciona uma nova tarefa ao pool.
+         *
+         * Se for chamada por uma thread do pool, a tarefa vai para a deque dessa thread; senão, para a fila de injeção
+         * (esperando, se ela estiver cheia). Se houver threads dormindo, uma delas é acordada; threads ainda procurando
+         * tarefas acham a nova sem precisar de sinal.
+         *
+         * @param task A tarefa a ser adicionada. Deve ser uma função que não recebe parâmetros.
+         * @param priority Classe de prioridade da tarefa
+         * @return future com o valor retornado pela tarefa (ou com a exceção lançada por ela)
+        */
+        template <typename F>
+        auto enqueue(F&& task, TaskPriority priority) -> future<invoke_result_t<decay_t<F>>> {
+            using Result = invoke_result_t<decay_t<F>>;
+
+            auto packaged = make_shared<packaged_task<Result()>>(forward<F>(task));
+            future<Result> result = packaged->get_future();
+            submit([packaged] { (*packaged)(); }, priority);
+            return result;
+        }
+
+        /*
+         * Adiciona uma nova tarefa ao pool, com a prioridade da tarefa atual (NORMAL se chamada de fora do pool).
+         *
+         * @param task A tarefa a ser adicionada. Deve ser uma função que não recebe parâmetros.
+         * @return future com o valor retornado pela tarefa (ou com a exceção lançada por ela)
+        */
+        template <typename F>
+        auto enqueue(F&& task) -> future<invoke_result_t<decay_t<F>>> {
+            return enqueue(forward<F>(task), current_priority());
+        }
+
+        /*
+         * Adiciona uma nova tarefa ao pool, sem criar um future (usado por `enqueue`).
+         *
+         * @param task A tarefa a ser adicionada. Deve ser uma função que não recebe parâmetros e não retorna valor.
+         * @param priority Classe de prioridade da tarefa
+         * @param global Se verdadeiro, a tarefa vai para o fim da fila de injeção mesmo vindo de uma thread do pool,
+         *               atrás das tarefas já esperando (usado por uma tarefa que cede a vez às outras)
+        */
+        void submit(function<void()> task, TaskPriority priority, bool global = false) {
+            Task* item = new Task{move(task), priority, now()};
+
+            bool in_pool = current_worker != nullptr && current_worker->pool == this;
+            if (!global && in_pool) {
+                current_worker->tasks.push(item);
+            } else {
+                PriorityClass& c = classes[(int) priority];
+
+                // Uma classe que estava vazia começa a contar o tempo sem ser atendida agora
+                if (c.queued.fetch_add(1, memory_order_acq_rel) == 0) c.served_at.store(item->enqueued_at, memory_order_relaxed);
+                while (!c.injection.try_push(item)) {
+                    // Fila de injeção cheia: uma thread do pool não pode esperar que ela esvazie (se todas esperassem,
+                    // ninguém a esvaziaria). A tarefa vai para a fila local, de onde as outras threads podem roubá-la
+                    if (in_pool) {
+                        c.queued.fetch_sub(1, memory_order_acq_rel);
+                        current_worker->tasks.push(item);
+                        break;
+                    }
+                    sched_yield();
+                }
+            }
+
+            // Conta a tarefa e acorda uma thread, se alguma estiver dormindo
+            pending.fetch_add(1, memory_order_seq_cst);
+            if (sleeping.load(memory_order_seq_cst) > 0) {
+                pthread_mutex_lock(&mtx);
+                pthread_cond_signal(&cond_var);
+                pthread_mutex_unlock(&mtx);
+            }
+        }
+
+        // Adiciona uma nova tarefa ao pool, com a prioridade da tarefa atual
+        void submit(function<void()> task) {
+            submit(move(task), current_priority());
+        }
+
+        /*
+         * Retorna a prioridade da tarefa que a thread atual está executando.
+         * @return prioridade da tarefa atual, ou NORMAL se a thread não pertence ao pool
+        */
+        TaskPriority current_priority() const {
+            if (current_worker != nullptr && current_worker->pool == this) return current_worker->running;
+            return TaskPriority::NORMAL;
+        }
+
+        /*
+         * Retorna o atraso de fila das tarefas de uma classe de prioridade já iniciadas desde a criação do pool.
+         * @param priority Classe de prioridade
+         * @return quantidade de tarefas, atraso médio e atraso máximo (em milissegundos)
+        */
+        QueueDelayStats queue_delay(TaskPriority priority) const {
+            const PriorityClass& c = classes[(int) priority];
+            int64_t tasks = c.started.load(memory_order_relaxed);
+            double total = c.total_delay.load(memory_order_relaxed) / 1e6;
+            return {tasks, tasks > 0 ? total / tasks : 0.0, c.max_delay.load(memory_order_relaxed) / 1e6};
+        }
+
+        /*
+         * Retorna o nó NUMA da thread atual.
+         * Threads fixadas usam o nó da CPU em que foram fixadas; as demais, o nó da CPU em que estão rodando agora.
+         * @return nó NUMA (renumerado, de 0 a `CpuTopology::node_count()` - 1)
+        */
+        static int current_node() {
+            if (current_worker != nullptr && current_worker->node >= 0) return current_worker->node;
+
+            int cpu = sched_getcpu();
+            return cpu < 0 ? 0 : CpuTopology::instance().node_of(cpu);
+        }
+
+        /*
+         * Retorna o peso de cada nó NUMA na divisão do trabalho: a quantidade de threads fixadas em cada nó.
+         * Se as threads não foram fixadas, todos os nós têm o mesmo peso.
+         * @return vetor com um peso por nó (de 0 a `CpuTopology::node_count()` - 1)
+        */
+        vector<int> workers_per_node() const {
+            vector<int> weights(CpuTopology::instance().node_count(), 0);
+            int n = active.load();
+            for (int i = 0; i < n; i++) {
+                if (workers[i]->node < 0) return vector<int>(weights.size(), 1);
+                weights[workers[i]->node]++;
+            }
+            return weights;
+        }
+
+        /*
+         * Retorna se há tarefas esperando para começar (em qualquer deque ou fila de injeção).
+        */
+        bool has_waiting_tasks() const {
+            return pending.load(memory_order_relaxed) > 0;
+        }
+
+        /*
+         * Retorna se o pool está ocioso: nenhuma tarefa esperando nem sendo executada.
+        */
+        bool is_idle() const {
+            return pending.load(memory_order_acquire) <= 0 && busy.load(memory_order_acquire) == 0;
+        }
+
+        /*
+         * Retorna a quantidade de threads do pool.
+        */
+        int size() const {
+            return active.load();
         }
 
         /*
@@ -203,11 +680,8 @@ class ThreadPool {
          * @return true se todas as tarefas foram concluídas e o pool deve parar, false caso contrário.
         */
         bool is_everything_done() {
-            pthread_mutex_lock(&mtx);
-            bool result = tasks.empty() && stop;
-            pthread_mutex_unlock(&mtx);
-            return result;
+            return pending.load() <= 0 && stop.load();
         }
 };
 
-#endif // _THREADPOOL_HPP_
\ No newline at end of file
+#endif // _THREADPOOL_HPP_
@@ -0,0 +1,100 @@
+#ifndef _BOX_FILTER_HPP_
+#define _BOX_FILTER_HPP_
+
+#include <vector>
+#include <algorithm>
+#include <opencv2/opencv.hpp>
+#include "region.hpp"
+#include "padded_image.hpp"
+#include "cancellation.hpp"
+
+using namespace std;
+using namespace cv;
+
+/*
+    * Calcula, para cada pixel da região, a soma da janela (2r+1)x(2r+1) ao seu redor usando somas deslizantes.
+    *
+    * Mantém a soma de cada coluna da janela vertical (atualizada somando a linha que entra e subtraindo a que sai)
+    * e desliza uma segunda soma na horizontal sobre essas colunas. Assim o custo por pixel é O(1), independente do raio.
+    * Os pixels fora da imagem vêm da borda de zeros de `src` (zero-padding), então nenhum laço testa os limites.
+    *
+    * Para cada linha y da região, chama `row_fn(y, sums)`, onde `sums` guarda as somas dos pixels
+    * x_begin..x_end da linha, com `nc` canais intercalados (nc = canais da imagem ou 1 se `only_channel` >= 0).
+    *
+    * @param src Imagem de entrada com borda de zeros de pelo menos `radius` pixels
+    * @param region Região da imagem a ser processada
+    * @param radius Raio da janela
+    * @param only_channel Se for -1, soma todos os canais. Caso contrário, soma apenas esse canal
+    * @param row_fn Função chamada com as somas de cada linha da região
+    * @returns: void
+*/
+template <typename RowFn>
+inline void box_sum_rows(const PaddedImage& src, Region region, int radius, int only_channel, RowFn row_fn) {
+    const int cn = src.cn;
+
+    const int first_channel = (only_channel < 0) ? 0 : only_channel;
+    const int nc = (only_channel < 0) ? cn : 1;
+
+    // colunas (incluindo as da borda de zeros) que entram em alguma janela da região
+    const int col_begin = region.x_begin - radius;
+    const int num_cols = (region.x_end + radius) - col_begin + 1;
+
+    const int region_width = region.x_end - region.x_begin + 1;
+
+    // Soma vertical de cada coluna, para a janela de linhas da linha atual
+    vector<int> column_sums((size_t) num_cols * nc, 0);
+
+    // Resultado de uma linha, repassado para `row_fn`
+    vector<int> sums((size_t) region_width * nc);
+
+    // Soma uma linha da imagem nas somas das colunas (sign = 1) ou a remove (sign = -1)
+    auto accumulate_row = [&](int y, int sign) {
+        const uchar* input_row = src.row(y) + col_begin * cn + first_channel;
+        for (int i = 0; i < num_cols; i++) {
+            for (int c = 0; c < nc; c++) {
+                column_sums[i * nc + c] += sign * input_row[i * cn + c];
+            }
+        }
+    };
+
+    // Inicializa as somas das colunas com a janela da primeira linha da região
+    for (int y = region.y_begin - radius; y <= region.y_begin + radius; y++) {
+        accumulate_row(y, 1);
+    }
+
+    for (int y = region.y_begin; y <= region.y_end; y++) {
+        // Para se o job foi cancelado
+        if (CancellationToken::requested()) return;
+
+        // Desliza a janela vertical: entra a linha y + radius e sai a linha y - radius - 1
+        if (y > region.y_begin) {
+            accumulate_row(y + radius, 1);
+            accumulate_row(y - radius - 1, -1);
+        }
+
+        // Soma horizontal da janela do primeiro pixel da região
+        int window[4] = {0, 0, 0, 0};
+        for (int i = 0; i < 2 * radius + 1; i++) {
+            for (int c = 0; c < nc; c++) {
+                window[c] += column_sums[i * nc + c];
+            }
+        }
+
+        for (int x = region.x_begin; x <= region.x_end; x++) {
+            // Desliza a janela horizontal: entra a coluna x + radius e sai a coluna x - radius - 1
+            if (x > region.x_begin) {
+                for (int c = 0; c < nc; c++) {
+                    window[c] += column_sums[(x + radius - col_begin) * nc + c] - column_sums[(x - radius - 1 - col_begin) * nc + c];
+                }
+            }
+
+            for (int c = 0; c < nc; c++) {
+                sums[(x - region.x_begin) * nc + c] = window[c];
+            }
+        }
+
+        row_fn(y, sums.data());
+    }
+}
+
+#endif // _BOX_FILTER_HPP_
@@ -0,0 +1,98 @@
+#ifndef _CANCELLATION_HPP_
+#define _CANCELLATION_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+
+using namespace std;
+using namespace std::chrono;
+
+/*
+    * Classe CancellationToken
+    *
+    * Pedido de cancelamento de um processamento (job), compartilhado por todas as tarefas dele.
+    * O cancelamento é cooperativo: quem cancela só marca o token, e os filtros conferem o token da tarefa atual
+    * a cada linha (e as threads, a cada bloco), parando assim que o veem marcado.
+    *
+    * O token da tarefa atual fica em uma variável thread_local, definida por `CancellationScope` no começo da tarefa,
+    * para que os laços dos filtros não precisem receber o token como parâmetro.
+    *
+    * Também mede a latência do cancelamento: o tempo entre o pedido e a última tarefa do job parar.
+*/
+class CancellationToken {
+    private:
+        // Se o cancelamento foi pedido
+        atomic<bool> cancelled{false};
+
+        // Instante do pedido de cancelamento e instante em que a última tarefa parou (em nanossegundos do steady_clock)
+        atomic<int64_t> requested_at{0};
+        atomic<int64_t> stopped_at{0};
+
+        static int64_t now() {
+            return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+        }
+
+    public:
+        // Token da tarefa que a thread atual está executando (nullptr fora de uma tarefa cancelável)
+        inline static thread_local const CancellationToken* current = nullptr;
+
+        // Pede o cancelamento (só o primeiro pedido conta para a latência)
+        void cancel() {
+            int64_t expected = 0;
+            requested_at.compare_exchange_strong(expected, now(), memory_order_relaxed);
+            cancelled.store(true, memory_order_release);
+        }
+
+        // Retorna se o cancelamento foi pedido
+        bool is_cancelled() const {
+            return cancelled.load(memory_order_acquire);
+        }
+
+        // Registra que uma parte do job parou; a latência vai até a última parte
+        void mark_stopped() {
+            int64_t t = now();
+            int64_t previous = stopped_at.load(memory_order_relaxed);
+            while (previous < t && !stopped_at.compare_exchange_weak(previous, t, memory_order_relaxed)) {}
+        }
+
+        /*
+            * Retorna a latência do cancelamento: o tempo entre o pedido e a última parte do job parar.
+            * @returns: latência em milissegundos, ou -1 se o job não foi cancelado ou ainda não parou
+        */
+        double latency_ms() const {
+            int64_t requested = requested_at.load(memory_order_relaxed);
+            int64_t stopped = stopped_at.load(memory_order_relaxed);
+            if (requested == 0 || stopped == 0) return -1;
+            return max<int64_t>(0, stopped - requested) / 1e6;
+        }
+
+        // Retorna se o job da tarefa atual foi cancelado (conferido pelos filtros a cada linha)
+        static bool requested() {
+            return current != nullptr && current->is_cancelled();
+        }
+};
+
+/*
+    * Define o token da tarefa atual enquanto o objeto existir (no começo de cada tarefa de um job),
+    * restaurando o anterior ao sair.
+*/
+class CancellationScope {
+    private:
+        const CancellationToken* previous;
+
+    public:
+        explicit CancellationScope(const CancellationToken* token) : previous(CancellationToken::current) {
+            CancellationToken::current = token;
+        }
+
+        ~CancellationScope() {
+            CancellationToken::current = previous;
+        }
+
+        CancellationScope(const CancellationScope&) = delete;
+        CancellationScope& operator=(const CancellationScope&) = delete;
+};
+
+#endif // _CANCELLATION_HPP_
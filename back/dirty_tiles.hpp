@@ -0,0 +1,156 @@
+#ifndef _DIRTY_TILES_HPP_
+#define _DIRTY_TILES_HPP_
+
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+#include <opencv2/opencv.hpp>
+#include "region.hpp"
+
+using namespace std;
+using namespace cv;
+
+/*
+    * Sinal de progresso de um processamento: um contador de versões, incrementado a cada mudança
+    * (bloco concluído, saída concluída, cancelamento), e uma variável de condição para quem espera a próxima mudança.
+*/
+class ProgressSignal {
+    private:
+        uint64_t version = 0;
+        mutex mtx;
+        condition_variable cond_var;
+
+    public:
+        // Registra uma mudança e acorda quem está esperando
+        void notify() {
+            {
+                lock_guard<mutex> lock(this->mtx);
+                this->version++;
+            }
+            this->cond_var.notify_all();
+        }
+
+        // Versão atual (a ser passada para `wait_for` depois de conferir o estado)
+        uint64_t current() {
+            lock_guard<mutex> lock(this->mtx);
+            return this->version;
+        }
+
+        /*
+            * Espera a versão passar de `seen`, por no máximo `timeout`.
+            * @param seen Versão lida antes de conferir o estado
+            * @param timeout Tempo máximo de espera
+            * @returns: true se houve mudança
+        */
+        bool wait_for(uint64_t seen, chrono::milliseconds timeout) {
+            unique_lock<mutex> lock(this->mtx);
+            return this->cond_var.wait_for(lock, timeout, [&] { return this->version != seen; });
+        }
+};
+
+/*
+    * Classe DirtyTiles
+    *
+    * Acompanha quais blocos de uma imagem de saída já foram processados, para que o frontend receba só o que mudou
+    * desde a última consulta, em vez da imagem inteira.
+    *
+    * Cada bloco concluído recebe o próximo número de sequência. Quem consulta guarda o maior número que já viu
+    * e pede os blocos com número maior. Cada bloco é codificado (ex.: em PNG) uma única vez, na primeira consulta
+    * que o retorna, e os bytes ficam guardados para as próximas.
+    * Também guarda qual thread concluiu cada bloco, e avisa o sinal de progresso (se houver) a cada bloco concluído.
+*/
+class DirtyTiles {
+    private:
+        // Blocos da imagem, o número de sequência em que cada um foi concluído (0 se ainda não foi) e a thread que o concluiu
+        vector<Region> tiles;
+        vector<uint64_t> version;
+        vector<int> owner;
+
+        // Último número de sequência usado
+        uint64_t sequence = 0;
+
+        // Sinal avisado a cada bloco concluído (pode ser nulo)
+        shared_ptr<ProgressSignal> signal;
+
+        // Protege `version`, `owner` e `sequence` (marcar e consultar são rápidos; a codificação fica fora do lock)
+        mutable mutex mtx;
+
+        // Bytes codificados de cada bloco, preenchidos uma única vez
+        unique_ptr<once_flag[]> encode_once;
+        vector<vector<uchar>> encoded;
+
+    public:
+        /*
+            * Construtor da classe DirtyTiles.
+            * @param tiles Blocos da imagem de saída
+            * @param signal Sinal avisado a cada bloco concluído (opcional)
+        */
+        explicit DirtyTiles(const vector<Region>& tiles, shared_ptr<ProgressSignal> signal = nullptr)
+            : tiles(tiles), version(tiles.size(), 0), owner(tiles.size(), -1), signal(signal),
+              encode_once(new once_flag[tiles.size()]), encoded(tiles.size()) {}
+
+        /*
+            * Marca um bloco como concluído. Deve ser chamada depois que o bloco inteiro foi escrito na saída.
+            * @param index Índice do bloco
+            * @param worker Índice da thread que processou o bloco
+        */
+        void mark(int index, int worker) {
+            {
+                lock_guard<mutex> lock(this->mtx);
+                this->version[index] = ++this->sequence;
+                this->owner[index] = worker;
+            }
+            if (this->signal) this->signal->notify();
+        }
+
+        /*
+            * Retorna os blocos concluídos depois do número de sequência `since`.
+            * @param since Maior número de sequência que quem consulta já viu (0 na primeira consulta)
+            * @param current Recebe o número de sequência atual, a ser passado como `since` na próxima consulta
+            * @returns: índices dos blocos, em ordem de conclusão
+        */
+        vector<int> changed_since(uint64_t since, uint64_t& current) const {
+            vector<int> changed;
+            lock_guard<mutex> lock(this->mtx);
+            current = this->sequence;
+            for (size_t i = 0; i < this->tiles.size(); i++) {
+                if (this->version[i] > since) changed.push_back(i);
+            }
+            sort(changed.begin(), changed.end(), [&](int a, int b) { return this->version[a] < this->version[b]; });
+            return changed;
+        }
+
+        /*
+            * Retorna os bytes codificados de um bloco concluído, codificando-o na primeira chamada.
+            * @param index Índice do bloco
+            * @param encode Função que codifica a região do bloco
+            * @returns: bytes codificados do bloco
+        */
+        const vector<uchar>& encoded_tile(int index, const function<vector<uchar>(const Region&)>& encode) {
+            call_once(this->encode_once[index], [&] { this->encoded[index] = encode(this->tiles[index]); });
+            return this->encoded[index];
+        }
+
+        // Região de um bloco
+        const Region& tile(int index) const {
+            return this->tiles[index];
+        }
+
+        // Thread que concluiu um bloco (-1 se ainda não foi concluído)
+        int worker(int index) const {
+            lock_guard<mutex> lock(this->mtx);
+            return this->owner[index];
+        }
+
+        // Quantidade de blocos
+        int size() const {
+            return this->tiles.size();
+        }
+};
+
+#endif // _DIRTY_TILES_HPP_
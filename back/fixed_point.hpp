@@ -0,0 +1,209 @@
+#ifndef _FIXED_POINT_HPP_
+#define _FIXED_POINT_HPP_
+
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <climits>
+#include <algorithm>
+#include <opencv2/opencv.hpp>
+#include "simd.hpp"
+
+using namespace std;
+using namespace cv;
+
+/*
+    * Caminho de convolução em ponto fixo, usado pelo filtro gaussiano
+    * (os filtros de máscara já são só inteiros, pelos stencils 3x3 de stencil.hpp).
+    *
+    * Os pesos do kernel são quantizados para inteiros de 16 bits (peso * 2^frac_bits), os produtos são
+    * acumulados em 32 bits e o resultado é deslocado de volta e saturado em [0, 255] ao gravar.
+    * O laço principal multiplica e acumula dois taps por vez (pmaddwd), processando 8 (SSSE3) ou 16 (AVX2)
+    * posições por instrução, contra 4 ou 8 do caminho em float.
+    *
+    * O resultado fica idêntico ou a ±1 da convolução separável em float, por causa do arredondamento dos pesos.
+    * Isso só vale abaixo de RECURSIVE_GAUSSIAN_MIN_RADIUS: a partir desse raio o caminho em float usa o filtro
+    * recursivo (gaussian.hpp), que só aproxima a convolução, e os dois caminhos podem diferir em vários níveis.
+*/
+
+// Aritmética usada pelas convoluções do gaussiano
+enum class ConvolutionPath {
+    FLOAT, FIXED
+};
+
+/*
+    * Quantiza um kernel em float para ponto fixo de 16 bits.
+    * O peso central absorve o erro de arredondamento, para que a soma dos pesos quantizados seja
+    * exatamente a soma original * 2^frac_bits (assim regiões uniformes saem sem erro).
+    * @param kernel Kernel em float, de tamanho ímpar
+    * @param frac_bits Quantidade de bits da parte fracionária
+    * @returns: vetor com os pesos quantizados
+*/
+inline vector<int16_t> quantize_kernel(const vector<float>& kernel, int frac_bits) {
+    const float scale = (float) (1 << frac_bits);
+    vector<int16_t> fixed(kernel.size());
+
+    double target = 0.0;
+    int sum = 0;
+    for (size_t i = 0; i < kernel.size(); i++) {
+        fixed[i] = (int16_t) std::lround(kernel[i] * scale);
+        target += kernel[i] * scale;
+        sum += fixed[i];
+    }
+    fixed[kernel.size() / 2] += (int16_t) (std::lround(target) - sum);
+
+    return fixed;
+}
+
+// VERSÕES ESCALARES //////////////////////////////////
+
+// acc[i] += a[i] * wa + b[i] * wb, com entradas de 8 bits sem sinal
+inline void mac2_u8_scalar(const uchar* a, const uchar* b, int16_t wa, int16_t wb, int32_t* acc, int n) {
+    for (int i = 0; i < n; i++) acc[i] += a[i] * wa + b[i] * wb;
+}
+
+// acc[i] += a[i] * wa + b[i] * wb, com entradas de 16 bits com sinal
+inline void mac2_s16_scalar(const int16_t* a, const int16_t* b, int16_t wa, int16_t wb, int32_t* acc, int n) {
+    for (int i = 0; i < n; i++) acc[i] += a[i] * wa + b[i] * wb;
+}
+
+#ifdef SIMD_X86
+
+// Par de pesos (wa, wb) repetido em cada inteiro de 32 bits, no formato esperado pelo pmaddwd
+inline int32_t pack_weight_pair(int16_t wa, int16_t wb) {
+    return (int32_t) (((uint32_t) (uint16_t) wb << 16) | (uint16_t) wa);
+}
+
+// VERSÕES SSSE3 //////////////////////////////////
+
+// Intercala a[i] e b[i] (16 bits) e acumula a[i] * wa + b[i] * wb em 8 inteiros de 32 bits
+__attribute__((target("ssse3")))
+inline void mac2_block_ssse3(__m128i a16, __m128i b16, __m128i weights, int32_t* acc) {
+    __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi16(a16, b16), weights);
+    __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi16(a16, b16), weights);
+    _mm_storeu_si128((__m128i*) acc, _mm_add_epi32(_mm_loadu_si128((const __m128i*) acc), lo));
+    _mm_storeu_si128((__m128i*) (acc + 4), _mm_add_epi32(_mm_loadu_si128((const __m128i*) (acc + 4)), hi));
+}
+
+__attribute__((target("ssse3")))
+inline void mac2_u8_ssse3(const uchar* a, const uchar* b, int16_t wa, int16_t wb, int32_t* acc, int n) {
+    const __m128i weights = _mm_set1_epi32(pack_weight_pair(wa, wb));
+    const __m128i zero = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i a16 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*) (a + i)), zero);
+        __m128i b16 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*) (b + i)), zero);
+        mac2_block_ssse3(a16, b16, weights, acc + i);
+    }
+    mac2_u8_scalar(a + i, b + i, wa, wb, acc + i, n - i);
+}
+
+__attribute__((target("ssse3")))
+inline void mac2_s16_ssse3(const int16_t* a, const int16_t* b, int16_t wa, int16_t wb, int32_t* acc, int n) {
+    const __m128i weights = _mm_set1_epi32(pack_weight_pair(wa, wb));
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i a16 = _mm_loadu_si128((const __m128i*) (a + i));
+        __m128i b16 = _mm_loadu_si128((const __m128i*) (b + i));
+        mac2_block_ssse3(a16, b16, weights, acc + i);
+    }
+    mac2_s16_scalar(a + i, b + i, wa, wb, acc + i, n - i);
+}
+
+// VERSÕES AVX2 //////////////////////////////////
+
+// Igual à versão SSSE3, com 16 posições. O unpack do AVX2 age em cada metade de 128 bits,
+// então os resultados são reordenados (permute2x128) antes de somar no acumulador
+__attribute__((target("avx2")))
+inline void mac2_block_avx2(__m256i a16, __m256i b16, __m256i weights, int32_t* acc) {
+    __m256i lo = _mm256_madd_epi16(_mm256_unpacklo_epi16(a16, b16), weights); // posições 0-3 e 8-11
+    __m256i hi = _mm256_madd_epi16(_mm256_unpackhi_epi16(a16, b16), weights); // posições 4-7 e 12-15
+    __m256i first = _mm256_permute2x128_si256(lo, hi, 0x20);
+    __m256i second = _mm256_permute2x128_si256(lo, hi, 0x31);
+    _mm256_storeu_si256((__m256i*) acc, _mm256_add_epi32(_mm256_loadu_si256((const __m256i*) acc), first));
+    _mm256_storeu_si256((__m256i*) (acc + 8), _mm256_add_epi32(_mm256_loadu_si256((const __m256i*) (acc + 8)), second));
+}
+
+__attribute__((target("avx2")))
+inline void mac2_u8_avx2(const uchar* a, const uchar* b, int16_t wa, int16_t wb, int32_t* acc, int n) {
+    const __m256i weights = _mm256_set1_epi32(pack_weight_pair(wa, wb));
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i a16 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*) (a + i)));
+        __m256i b16 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*) (b + i)));
+        mac2_block_avx2(a16, b16, weights, acc + i);
+    }
+    mac2_u8_scalar(a + i, b + i, wa, wb, acc + i, n - i);
+}
+
+__attribute__((target("avx2")))
+inline void mac2_s16_avx2(const int16_t* a, const int16_t* b, int16_t wa, int16_t wb, int32_t* acc, int n) {
+    const __m256i weights = _mm256_set1_epi32(pack_weight_pair(wa, wb));
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i a16 = _mm256_loadu_si256((const __m256i*) (a + i));
+        __m256i b16 = _mm256_loadu_si256((const __m256i*) (b + i));
+        mac2_block_avx2(a16, b16, weights, acc + i);
+    }
+    mac2_s16_scalar(a + i, b + i, wa, wb, acc + i, n - i);
+}
+
+#endif // SIMD_X86
+
+// DESPACHO //////////////////////////////////
+
+// Tabela com os kernels de multiplicação e acumulação escolhidos para a CPU atual
+struct FixedPointKernels {
+    SimdLevel level;
+    void (*mac2_u8)(const uchar*, const uchar*, int16_t, int16_t, int32_t*, int);
+    void (*mac2_s16)(const int16_t*, const int16_t*, int16_t, int16_t, int32_t*, int);
+};
+
+/*
+    * Monta a tabela de kernels de ponto fixo de um nível de SIMD.
+    * @param level Nível de SIMD desejado
+    * @returns: tabela de kernels
+*/
+inline FixedPointKernels make_fixed_point_kernels(SimdLevel level) {
+    FixedPointKernels k = {SimdLevel::SCALAR, mac2_u8_scalar, mac2_s16_scalar};
+#ifdef SIMD_X86
+    if (level == SimdLevel::SSSE3) k = {SimdLevel::SSSE3, mac2_u8_ssse3, mac2_s16_ssse3};
+    if (level == SimdLevel::AVX2) k = {SimdLevel::AVX2, mac2_u8_avx2, mac2_s16_avx2};
+#endif
+    return k;
+}
+
+/*
+    * Retorna os kernels de ponto fixo da CPU atual, detectados uma única vez (na primeira chamada, feita pelo construtor de `Image`).
+    * @returns: referência para a tabela de kernels
+*/
+inline const FixedPointKernels& fixed_point_kernels() {
+    static const FixedPointKernels kernels = make_fixed_point_kernels(detect_simd_level());
+    return kernels;
+}
+
+/*
+    * Convolui uma linha de 8 bits com um kernel 1D de ponto fixo, somando em `acc`:
+    * acc[i] += sum_t kernel[t] * src[i + (t - radius) * step], para i em [0, n).
+    * Os taps são processados em pares; com quantidade ímpar, o último par usa peso zero.
+    * @param src Primeira posição da linha (precisa de radius * step posições válidas antes e depois)
+    * @param step Distância, em posições, entre dois taps vizinhos (ex.: quantidade de canais)
+    * @param kernel Kernel de ponto fixo de tamanho ímpar
+    * @param acc Acumulador de 32 bits com n posições
+    * @param n Quantidade de posições
+    * @returns: void
+*/
+inline void fixed_convolve_row_u8(const uchar* src, int step, const vector<int16_t>& kernel, int32_t* acc, int n) {
+    const FixedPointKernels& k = fixed_point_kernels();
+    const int taps = (int) kernel.size();
+    const uchar* first = src - (taps / 2) * step;
+
+    for (int t = 0; t < taps; t += 2) {
+        if (t + 1 < taps)
+            k.mac2_u8(first + t * step, first + (t + 1) * step, kernel[t], kernel[t + 1], acc, n);
+        else
+            k.mac2_u8(first + t * step, first + t * step, kernel[t], 0, acc, n);
+    }
+}
+
+#endif // _FIXED_POINT_HPP_
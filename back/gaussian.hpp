@@ -0,0 +1,464 @@
+#ifndef _GAUSSIAN_HPP_
+#define _GAUSSIAN_HPP_
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <opencv2/opencv.hpp>
+#include "region.hpp"
+#include "padded_image.hpp"
+#include "cancellation.hpp"
+#include "fixed_point.hpp"
+
+using namespace std;
+using namespace cv;
+
+/*
+    * Gera o kernel gaussiano 1D de acordo com o tamanho do kernel passado.
+    * Como a gaussiana 2D é separável (G(x, y) = g(x) * g(y)), o kernel 1D normalizado
+    * aplicado nas linhas e depois nas colunas equivale ao kernel 2D normalizado.
+    * @param kernelSize Tamanho do kernel (se for par, é incrementado para ficar ímpar)
+    * @returns: vetor com os pesos do kernel, somando 1
+*/
+inline vector<float> generateGaussianKernel1D(int kernelSize) {
+    if (kernelSize % 2 == 0) {
+        kernelSize++; // Garante que o tamanho do kernel seja ímpar
+    }
+
+    vector<float> kernel(kernelSize);
+
+    float sigma = kernelSize / 2.0f; // uma aproximação pra sigma baseada no tamanho
+    float sum = 0.0f;
+    int center = kernelSize / 2;
+
+    // Gera os pesos da gaussiana
+    for (int i = 0; i < kernelSize; i++) {
+        int x = i - center;
+        kernel[i] = std::exp(-(x * x) / (2.0f * sigma * sigma));
+        sum += kernel[i];
+    }
+
+    // Normaliza para que a soma total seja 1
+    for (int i = 0; i < kernelSize; i++) {
+        kernel[i] /= sum;
+    }
+
+    return kernel;
+}
+
+// Bits fracionários dos kernels gaussianos em ponto fixo (pesos em Q14, que somam 2^14)
+#define GAUSSIAN_FRAC_BITS 14
+
+// Bits fracionários do resultado intermediário da passada horizontal em ponto fixo (255 * 2^7 cabe em 16 bits)
+#define GAUSSIAN_MID_BITS 7
+
+/*
+    * Tabela com os kernels gaussianos 1D de todos os níveis de intensidade (1 a 40), em float e em ponto fixo.
+    *
+    * A tabela é montada uma única vez (na primeira chamada de `instance()`, feita pelo construtor de `Image`)
+    * e depois é apenas consultada, sem precisar de lock, por todas as threads que aplicam o filtro.
+*/
+class GaussianKernelTable {
+    private:
+        // kernels[nivel - 1] guarda o kernel 1D do nível de intensidade `nivel`
+        vector<vector<float>> kernels;
+        vector<vector<int16_t>> fixed_kernels;
+
+        GaussianKernelTable() {
+            for (int level = 1; level <= MAX_LEVEL; level++) {
+                kernels.push_back(generateGaussianKernel1D(level));
+                fixed_kernels.push_back(quantize_kernel(kernels.back(), GAUSSIAN_FRAC_BITS));
+            }
+        }
+
+    public:
+        // Maior nível de intensidade do filtro gaussiano
+        static const int MAX_LEVEL = 40;
+
+        /*
+            * Retorna a tabela de kernels, criando-a na primeira chamada.
+            * @returns: referência para a tabela única de kernels
+        */
+        static const GaussianKernelTable& instance() {
+            static const GaussianKernelTable table;
+            return table;
+        }
+
+        /*
+            * Retorna o kernel 1D do nível de intensidade pedido.
+            * @param level Nível de intensidade, limitado ao intervalo [1, MAX_LEVEL]
+            * @returns: referência para o kernel 1D
+        */
+        const vector<float>& get(int level) const {
+            level = std::clamp(level, 1, MAX_LEVEL);
+            return kernels[level - 1];
+        }
+
+        /*
+            * Retorna o kernel 1D do nível de intensidade pedido, quantizado em ponto fixo (Q14).
+            * @param level Nível de intensidade, limitado ao intervalo [1, MAX_LEVEL]
+            * @returns: referência para o kernel 1D em ponto fixo
+        */
+        const vector<int16_t>& get_fixed(int level) const {
+            level = std::clamp(level, 1, MAX_LEVEL);
+            return fixed_kernels[level - 1];
+        }
+};
+
+/*
+    * Aplica uma convolução gaussiana separável (primeiro horizontal, depois vertical) na região da imagem.
+    * O custo por pixel é O(r) ao invés do O(r²) da convolução com o kernel 2D.
+    * Os pixels fora da imagem vêm da borda de zeros de `src` (zero-padding), então nenhum laço testa os limites.
+    *
+    * @param src Imagem de entrada com borda de zeros de pelo menos o raio do kernel
+    * @param dst Imagem de saída, do mesmo tamanho e tipo da imagem original
+    * @param region Região da imagem a ser processada
+    * @param kernel Kernel gaussiano 1D normalizado
+    * @param only_channel Se for -1, filtra todos os canais. Caso contrário, filtra apenas esse canal e copia os demais de `src`
+    * @returns: void
+*/
+inline void separable_gaussian(const PaddedImage& src, Mat& dst, Region region, const vector<float>& kernel, int only_channel = -1) {
+    const int height = src.height;
+    const int cn = src.cn;
+    const int radius = (int) kernel.size() / 2;
+    const float* k = kernel.data() + radius; // permite indexar de -radius a radius
+
+    // canais que realmente serão filtrados
+    const int first_channel = (only_channel < 0) ? 0 : only_channel;
+    const int nc = (only_channel < 0) ? cn : 1;
+
+    const int region_width = region.x_end - region.x_begin + 1;
+
+    // linhas necessárias para a passada vertical (as de fora da imagem são zero)
+    const int row_begin = region.y_begin - radius;
+    const int row_end = region.y_end + radius;
+
+    // Buffer intermediário com o resultado da passada horizontal, apenas das colunas da região
+    vector<float> horizontal((size_t) (row_end - row_begin + 1) * region_width * nc, 0.0f);
+
+    // 1. PASSADA HORIZONTAL: convolui cada linha com o kernel 1D
+    // As linhas da borda de zeros resultam em zero, então só as linhas da imagem são calculadas
+    for (int y = max(0, row_begin); y <= min(height - 1, row_end); y++) {
+        if (CancellationToken::requested()) return;
+        const uchar* input_row = src.row(y);
+        float* tmp_row = &horizontal[(size_t) (y - row_begin) * region_width * nc];
+
+        for (int x = region.x_begin; x <= region.x_end; x++) {
+            for (int c = 0; c < nc; c++) {
+                const uchar* input = input_row + x * cn + first_channel + c;
+                float acc = 0.0f;
+                for (int t = -radius; t <= radius; t++) {
+                    acc += input[t * cn] * k[t];
+                }
+                tmp_row[(x - region.x_begin) * nc + c] = acc;
+            }
+        }
+    }
+
+    // 2. PASSADA VERTICAL: convolui as colunas do resultado horizontal, linha a linha
+    vector<float> acc((size_t) region_width * nc);
+    for (int y = region.y_begin; y <= region.y_end; y++) {
+        if (CancellationToken::requested()) return;
+        fill(acc.begin(), acc.end(), 0.0f);
+
+        for (int l = -radius; l <= radius; l++) {
+            const float* tmp_row = &horizontal[(size_t) (y + l - row_begin) * region_width * nc];
+            const float weight = k[l];
+            for (int i = 0; i < region_width * nc; i++) {
+                acc[i] += tmp_row[i] * weight;
+            }
+        }
+
+        const uchar* input_row = src.row(y);
+        uchar* output_row = dst.ptr<uchar>(y);
+
+        for (int x = region.x_begin; x <= region.x_end; x++) {
+            // copia os canais que não são filtrados (ex.: H e S no HSV)
+            if (nc != cn) {
+                for (int c = 0; c < cn; c++) {
+                    output_row[x * cn + c] = input_row[x * cn + c];
+                }
+            }
+
+            for (int c = 0; c < nc; c++) {
+                float value = acc[(x - region.x_begin) * nc + c];
+                output_row[x * cn + first_channel + c] = (uchar) std::clamp(std::round(value), 0.0f, 255.0f);
+            }
+        }
+    }
+}
+
+/*
+    * Mesma convolução gaussiana separável de `separable_gaussian`, em ponto fixo.
+    *
+    * A passada horizontal acumula pixel * peso (Q14) em 32 bits e guarda o resultado em 16 bits (Q7).
+    * A passada vertical acumula esses valores * peso (Q14) em 32 bits, e o resultado (Q21) é arredondado
+    * e saturado em [0, 255]. As duas passadas percorrem a linha como um vetor contínuo de bytes, com todos
+    * os canais intercalados; no HSV, apenas o canal V é gravado.
+    *
+    * @param src Imagem de entrada com borda de zeros de pelo menos o raio do kernel
+    * @param dst Imagem de saída, do mesmo tamanho e tipo da imagem original
+    * @param region Região da imagem a ser processada
+    * @param kernel Kernel gaussiano 1D em ponto fixo (Q14)
+    * @param only_channel Se for -1, filtra todos os canais. Caso contrário, filtra apenas esse canal e copia os demais de `src`
+    * @returns: void
+*/
+inline void separable_gaussian_fixed(const PaddedImage& src, Mat& dst, Region region, const vector<int16_t>& kernel, int only_channel = -1) {
+    const FixedPointKernels& k = fixed_point_kernels();
+    const int height = src.height;
+    const int cn = src.cn;
+    const int radius = (int) kernel.size() / 2;
+
+    // quantidade de posições (pixels * canais) de cada linha da região
+    const int row_length = (region.x_end - region.x_begin + 1) * cn;
+
+    const int row_begin = region.y_begin - radius;
+    const int row_end = region.y_end + radius;
+
+    const int horizontal_shift = GAUSSIAN_FRAC_BITS - GAUSSIAN_MID_BITS;
+    const int vertical_shift = GAUSSIAN_FRAC_BITS + GAUSSIAN_MID_BITS;
+
+    // Resultado da passada horizontal (Q7), as linhas de fora da imagem ficam zeradas
+    vector<int16_t> horizontal((size_t) (row_end - row_begin + 1) * row_length, 0);
+    vector<int32_t> acc(row_length);
+
+    // 1. PASSADA HORIZONTAL
+    for (int y = max(0, row_begin); y <= min(height - 1, row_end); y++) {
+        if (CancellationToken::requested()) return;
+        fill(acc.begin(), acc.end(), 0);
+        fixed_convolve_row_u8(src.row(y) + region.x_begin * cn, cn, kernel, acc.data(), row_length);
+
+        int16_t* tmp_row = &horizontal[(size_t) (y - row_begin) * row_length];
+        for (int i = 0; i < row_length; i++) {
+            tmp_row[i] = (int16_t) ((acc[i] + (1 << (horizontal_shift - 1))) >> horizontal_shift);
+        }
+    }
+
+    // 2. PASSADA VERTICAL
+    const int16_t* tmp = horizontal.data();
+    for (int y = region.y_begin; y <= region.y_end; y++) {
+        if (CancellationToken::requested()) return;
+        fill(acc.begin(), acc.end(), 0);
+
+        const int16_t* first = tmp + (size_t) (y - region.y_begin) * row_length; // linha y - radius
+        for (int l = 0; l < (int) kernel.size(); l += 2) {
+            const int16_t* a = first + (size_t) l * row_length;
+            if (l + 1 < (int) kernel.size())
+                k.mac2_s16(a, a + row_length, kernel[l], kernel[l + 1], acc.data(), row_length);
+            else
+                k.mac2_s16(a, a, kernel[l], 0, acc.data(), row_length);
+        }
+
+        const uchar* input_row = src.row(y) + region.x_begin * cn;
+        uchar* output_row = dst.ptr<uchar>(y) + region.x_begin * cn;
+
+        for (int i = 0; i < row_length; i++) {
+            int c = i % cn;
+            if (only_channel >= 0 && c != only_channel) {
+                output_row[i] = input_row[i]; // copia os canais que não são filtrados (ex.: H e S no HSV)
+            } else {
+                output_row[i] = saturate_cast<uchar>((acc[i] + (1 << (vertical_shift - 1))) >> vertical_shift);
+            }
+        }
+    }
+}
+
+// Raio do kernel a partir do qual o filtro gaussiano em float usa a versão recursiva (IIR)
+#define RECURSIVE_GAUSSIAN_MIN_RADIUS 8
+
+// Margem, em desvios padrão, que a recursão continua depois do fim da imagem antes de voltar
+#define RECURSIVE_GAUSSIAN_MARGIN_SIGMAS 5.0f
+
+// Quantidade de posições (colunas * canais) por bloco da passada vertical recursiva
+#define RECURSIVE_GAUSSIAN_COLUMN_BLOCK 64
+
+/*
+    * Coeficientes do filtro gaussiano recursivo de Young e van Vliet (1995), já divididos por b0:
+    * ida:   w[n] = B x[n] + b1 w[n-1] + b2 w[n-2] + b3 w[n-3]
+    * volta: y[n] = B w[n] + b1 y[n+1] + b2 y[n+2] + b3 y[n+3]
+*/
+typedef struct RecursiveGaussianCoefficients {
+    float B, b1, b2, b3;
+} RecursiveGaussianCoefficients;
+
+/*
+    * Calcula os coeficientes do filtro recursivo para o desvio padrão pedido.
+    * @param sigma Desvio padrão (a aproximação vale para sigma >= 0.5)
+    * @returns: coeficientes normalizados
+*/
+inline RecursiveGaussianCoefficients recursive_gaussian_coefficients(float sigma) {
+    float q = (sigma >= 2.5f) ? 0.98711f * sigma - 0.96330f
+                              : 3.97156f - 4.14554f * std::sqrt(1.0f - 0.26891f * sigma);
+
+    float b0 = 1.57825f + 2.44413f * q + 1.4281f * q * q + 0.422205f * q * q * q;
+    float b1 = 2.44413f * q + 2.85619f * q * q + 1.26661f * q * q * q;
+    float b2 = -(1.4281f * q * q + 1.26661f * q * q * q);
+    float b3 = 0.422205f * q * q * q;
+
+    return {1.0f - (b1 + b2 + b3) / b0, b1 / b0, b2 / b0, b3 / b0};
+}
+
+/*
+    * Desvio padrão efetivo de um kernel 1D normalizado (raiz do segundo momento em torno do centro).
+    * Os kernels da tabela são truncados em um sigma, então o desvio efetivo é bem menor que o sigma usado para gerá-los.
+    * @param kernel Kernel 1D normalizado
+    * @returns: desvio padrão do kernel
+*/
+inline float kernel_sigma(const vector<float>& kernel) {
+    const int center = (int) kernel.size() / 2;
+    float variance = 0.0f;
+    for (int i = 0; i < (int) kernel.size(); i++) {
+        variance += kernel[i] * (i - center) * (i - center);
+    }
+    return std::sqrt(variance);
+}
+
+/*
+    * Quantos pixels a recursão continua depois do fim da imagem (onde o sinal é zero), antes de voltar.
+    * A volta começa com estado zero, então a ida precisa seguir até a resposta dos últimos pixels se apagar.
+    * @param kernel Kernel gaussiano 1D normalizado
+    * @returns: margem em pixels
+*/
+inline int recursive_gaussian_margin(const vector<float>& kernel) {
+    return (int) std::ceil(RECURSIVE_GAUSSIAN_MARGIN_SIGMAS * kernel_sigma(kernel));
+}
+
+/*
+    * Filtro gaussiano recursivo (IIR, Young e van Vliet), em duas passadas sobre a imagem inteira.
+    * O custo por pixel é constante (uma recursão de 3 termos de ida e outra de volta em cada direção),
+    * independente do raio, então ele substitui a convolução separável nos kernels grandes.
+    *
+    * O desvio padrão é o desvio efetivo do kernel da tabela, para que a suavização fique próxima à da convolução
+    * (não idêntica: a resposta da recursão não é truncada como o kernel). Fora da imagem o sinal é zero,
+    * como na borda de zeros da convolução.
+    *
+    * Como a resposta é infinita, o filtro não é dividido em blocos 2D: primeiro `recursive_gaussian_rows` filtra
+    * linhas inteiras para um buffer em float e, só depois que todas as linhas terminaram,
+    * `recursive_gaussian_columns` filtra colunas inteiras do buffer para a saída. Cada linha e cada coluna passam
+    * sempre pela mesma conta, então o resultado não depende de como as linhas e colunas são repartidas entre as threads.
+*/
+
+/*
+    * Passada horizontal do filtro recursivo: ida e volta em cada linha e canal filtrado, para o buffer.
+    * @param src Imagem de entrada
+    * @param buffer Buffer com `src.height` linhas de `src.width * nc` floats (nc = canais filtrados)
+    * @param y_begin Primeira linha a filtrar
+    * @param y_end Última linha a filtrar
+    * @param kernel Kernel gaussiano 1D normalizado, usado para escolher o desvio padrão
+    * @param only_channel Se for -1, filtra todos os canais. Caso contrário, filtra apenas esse canal
+    * @returns: void
+*/
+inline void recursive_gaussian_rows(const PaddedImage& src, float* buffer, int y_begin, int y_end, const vector<float>& kernel, int only_channel = -1) {
+    const int width = src.width;
+    const int cn = src.cn;
+    const RecursiveGaussianCoefficients k = recursive_gaussian_coefficients(kernel_sigma(kernel));
+    const int cols = width + recursive_gaussian_margin(kernel);
+
+    const int first_channel = (only_channel < 0) ? 0 : only_channel;
+    const int nc = (only_channel < 0) ? cn : 1;
+    const size_t row_length = (size_t) width * nc;
+
+    // line[0..2] é o estado inicial (zero) da ida
+    vector<float> line(cols + 3, 0.0f);
+    float* w = line.data() + 3;
+
+    for (int y = y_begin; y <= y_end; y++) {
+        if (CancellationToken::requested()) return;
+        const uchar* input_row = src.row(y);
+        float* out = buffer + (size_t) y * row_length;
+
+        for (int c = 0; c < nc; c++) {
+            for (int x = 0; x < cols; x++) {
+                float value = (x < width) ? input_row[x * cn + first_channel + c] : 0.0f;
+                w[x] = k.B * value + k.b1 * w[x - 1] + k.b2 * w[x - 2] + k.b3 * w[x - 3];
+            }
+
+            float y1 = 0.0f, y2 = 0.0f, y3 = 0.0f;
+            for (int x = cols - 1; x >= 0; x--) {
+                float value = k.B * w[x] + k.b1 * y1 + k.b2 * y2 + k.b3 * y3;
+                y3 = y2; y2 = y1; y1 = value;
+                if (x < width) out[x * nc + c] = value;
+            }
+        }
+    }
+}
+
+/*
+    * Passada vertical do filtro recursivo, depois que todas as linhas do buffer foram filtradas:
+    * ida e volta em colunas inteiras, em blocos de RECURSIVE_GAUSSIAN_COLUMN_BLOCK posições contíguas,
+    * gravando as colunas x_begin..x_end na imagem de saída.
+    * @param src Imagem de entrada (para copiar os canais que não são filtrados)
+    * @param buffer Buffer preenchido por `recursive_gaussian_rows` em todas as linhas
+    * @param dst Imagem de saída, do mesmo tamanho e tipo da imagem original
+    * @param x_begin Primeira coluna a filtrar
+    * @param x_end Última coluna a filtrar
+    * @param kernel Kernel gaussiano 1D normalizado, usado para escolher o desvio padrão
+    * @param only_channel Se for -1, filtra todos os canais. Caso contrário, filtra apenas esse canal e copia os demais de `src`
+    * @returns: void
+*/
+inline void recursive_gaussian_columns(const PaddedImage& src, const float* buffer, Mat& dst, int x_begin, int x_end, const vector<float>& kernel, int only_channel = -1) {
+    const int height = src.height;
+    const int cn = src.cn;
+    const RecursiveGaussianCoefficients k = recursive_gaussian_coefficients(kernel_sigma(kernel));
+    const int rows = height + recursive_gaussian_margin(kernel);
+
+    const int first_channel = (only_channel < 0) ? 0 : only_channel;
+    const int nc = (only_channel < 0) ? cn : 1;
+    const size_t row_length = (size_t) src.width * nc;
+
+    // Colunas do bloco ao longo da imagem e da margem depois dela, com 3 linhas de estado zero antes e depois
+    vector<float> column((size_t) (rows + 6) * RECURSIVE_GAUSSIAN_COLUMN_BLOCK, 0.0f);
+
+    for (int block = x_begin * nc; block < (x_end + 1) * nc; block += RECURSIVE_GAUSSIAN_COLUMN_BLOCK) {
+        if (CancellationToken::requested()) return;
+        const int n = min(RECURSIVE_GAUSSIAN_COLUMN_BLOCK, (x_end + 1) * nc - block);
+        float* base = column.data() + 3 * RECURSIVE_GAUSSIAN_COLUMN_BLOCK;
+
+        // Ida: de cima para baixo (depois da imagem o sinal é zero)
+        for (int r = 0; r < rows; r++) {
+            float* cur = base + (size_t) r * RECURSIVE_GAUSSIAN_COLUMN_BLOCK;
+            const float* p1 = cur - RECURSIVE_GAUSSIAN_COLUMN_BLOCK;
+            const float* p2 = cur - 2 * RECURSIVE_GAUSSIAN_COLUMN_BLOCK;
+            const float* p3 = cur - 3 * RECURSIVE_GAUSSIAN_COLUMN_BLOCK;
+            const float* in = buffer + (size_t) r * row_length + block;
+            for (int i = 0; i < n; i++) {
+                float value = (r < height) ? in[i] : 0.0f;
+                cur[i] = k.B * value + k.b1 * p1[i] + k.b2 * p2[i] + k.b3 * p3[i];
+            }
+        }
+
+        // Volta: de baixo para cima, a partir do estado zero depois da margem
+        for (int r = rows - 1; r >= 0; r--) {
+            float* cur = base + (size_t) r * RECURSIVE_GAUSSIAN_COLUMN_BLOCK;
+            const float* n1 = cur + RECURSIVE_GAUSSIAN_COLUMN_BLOCK;
+            const float* n2 = cur + 2 * RECURSIVE_GAUSSIAN_COLUMN_BLOCK;
+            const float* n3 = cur + 3 * RECURSIVE_GAUSSIAN_COLUMN_BLOCK;
+            for (int i = 0; i < n; i++) {
+                cur[i] = k.B * cur[i] + k.b1 * n1[i] + k.b2 * n2[i] + k.b3 * n3[i];
+            }
+        }
+
+        // Grava o bloco na imagem de saída
+        for (int y = 0; y < height; y++) {
+            const float* filtered = base + (size_t) y * RECURSIVE_GAUSSIAN_COLUMN_BLOCK;
+            const uchar* input_row = src.row(y);
+            uchar* output_row = dst.ptr<uchar>(y);
+
+            for (int i = 0; i < n; i++) {
+                int x = (block + i) / nc;
+                int c = (block + i) % nc;
+
+                // copia os canais que não são filtrados (ex.: H e S no HSV)
+                if (nc != cn) {
+                    for (int j = 0; j < cn; j++) output_row[x * cn + j] = input_row[x * cn + j];
+                }
+                output_row[x * cn + first_channel + c] = (uchar) std::clamp(std::round(filtered[i]), 0.0f, 255.0f);
+            }
+        }
+
+        // A volta deixou estado nas 3 linhas depois da margem: zera para o próximo bloco
+        fill(base + (size_t) rows * RECURSIVE_GAUSSIAN_COLUMN_BLOCK, base + (size_t) (rows + 3) * RECURSIVE_GAUSSIAN_COLUMN_BLOCK, 0.0f);
+    }
+}
+
+#endif // _GAUSSIAN_HPP_
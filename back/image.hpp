@@ -8,10 +8,26 @@
 #include <opencv2/opencv.hpp>
 #include <string>
 #include <thread>
+#include <mutex>
 #include <vector>
 #include <time.h>
+#include <climits>
 #include <chrono>
 #include "ThreadPool.hpp"
+#include "wait_group.hpp"
+#include "cancellation.hpp"
+#include "region.hpp"
+#include "dirty_tiles.hpp"
+#include "content_hash.hpp"
+#include "gaussian.hpp"
+#include "box_filter.hpp"
+#include "median.hpp"
+#include "simd.hpp"
+#include "traversal.hpp"
+#include "padded_image.hpp"
+#include "stencil.hpp"
+#include "fixed_point.hpp"
+#include "lut.hpp"
 
 using namespace std;
 using namespace std::chrono;
@@ -25,17 +41,63 @@ enum class ImageColorType {
     RGB, HSV, GRAYSCALE
 };
 
+/*
+    * Fase das tarefas do processamento em multi-thread.
+    * TILES: cada tarefa filtra blocos. Os filtros recursivos, cuja resposta não cabe em margens, rodam em duas fases
+    * separadas por uma barreira: RECURSIVE_ROWS (linhas inteiras) e depois RECURSIVE_COLUMNS (colunas inteiras).
+*/
+enum class TilePhase {
+    TILES, RECURSIVE_ROWS, RECURSIVE_COLUMNS
+};
+
 typedef struct Timer{
     time_point<high_resolution_clock> start, end;
     duration<double, milli> timer_duration;
 } Timer;
 
-typedef struct Region{
-    int x_begin;
-    int x_end;
-    int y_begin;
-    int y_end;
-} Region;
+/*
+    * Bloco de uma imagem de saída que mudou desde a última consulta do progresso, já codificado (PNG).
+*/
+typedef struct TileUpdate{
+    Region region;
+    vector<uchar> bytes;
+} TileUpdate;
+
+/*
+    * Imagem de saída final já codificada (no formato da imagem de entrada), com a ETag (hash do conteúdo, entre aspas).
+*/
+typedef struct EncodedImage{
+    vector<uchar> bytes;
+    string etag;
+} EncodedImage;
+
+/*
+    * Bloco de uma imagem de saída concluído, com a thread que o processou (0 na saída single-thread).
+*/
+typedef struct TileCompletion{
+    Region region;
+    int worker;
+} TileCompletion;
+
+// Maior raio de vizinhança usado pelos filtros com as intensidades do frontend (blur, mediana e gaussiano com intensidade 20)
+// É a largura da borda de zeros montada ao receber uma imagem
+#define MAX_FILTER_RADIUS 20
+
+// Intervalo de intensidades aceito pelos filtros (o mesmo do controle do frontend)
+#define MIN_FILTER_INTENSITY 1
+#define MAX_FILTER_INTENSITY 20
+
+// Lado padrão, em pixels, dos blocos (tiles) distribuídos entre as threads no processamento em multi-thread
+#define DEFAULT_TILE_SIZE 128
+
+// Fatia de tempo, em microssegundos, de uma tarefa de blocos antes de ceder a vez às tarefas de outros processamentos
+#define TILE_TASK_QUANTUM_US 2000
+
+// Tempo máximo, em milissegundos, que o modo benchmark espera o pool ficar ocioso antes de medir
+#define BENCHMARK_QUIESCE_TIMEOUT_MS 5000
+
+// Tamanho, em bytes, do buffer usado para esvaziar os caches se o tamanho do cache não puder ser lido do sysfs
+#define BENCHMARK_FLUSH_FALLBACK_BYTES (64 << 20)
 
 typedef struct Mask_t{
     vector<vector<float>> mask_;
@@ -58,12 +120,12 @@ private:
     // Guarda o tipo de cor da imagem (RGB, HSV, GRAYSCALE)
     ImageColorType color_type;
 
+    // Guarda uma cópia da imagem de entrada com borda de zeros, usada pelos filtros de vizinhança
+    PaddedImage image_padded;
+
     // Guarda o caminho da imagem recebida como input
     string path;
 
-    // Guarda o buffer da imagem recebida como input
-    vector<uchar> buffer;
-
     // Guarda o tamanho da imagem recebida como input (largura e altura)
     int width;
     int height;
@@ -77,29 +139,125 @@ private:
     // Guarda a intensidade do filtro aplicado
     int intensity = 1;
 
-    // Guarda a pool de threads utilizadas para o processamento da imagem
-    unique_ptr<ThreadPool> thread_pool;
+    // Guarda a aritmética usada pela convolução do gaussiano: float ou ponto fixo
+    ConvolutionPath convolution_path = ConvolutionPath::FLOAT;
+
+    // Guarda a tabela de consulta do filtro pontual atual (gama, contraste, posterização), montada uma vez em `process`
+    PointLut point_lut;
+
+    // Guarda a pool de threads utilizadas para o processamento da imagem (pode ser compartilhada com outras imagens)
+    shared_ptr<ThreadPool> thread_pool;
+
+    // Guarda os grupos de espera do processamento atual em single e multi-threading
+    // Cada tarefa chama `done()` ao terminar; a última para o timer e marca o processamento como concluído
+    shared_ptr<WaitGroup> single_thread_group;
+    shared_ptr<WaitGroup> multi_thread_group;
+
+    // Guarda o número do processamento atual, para que tarefas de um processamento anterior não marquem o atual como concluído
+    atomic<int> job_id{0};
+
+    // Guarda o token de cancelamento do processamento atual, conferido pelas tarefas dele a cada linha e a cada bloco
+    shared_ptr<CancellationToken> cancel_token;
+
+    // Guarda a latência do último cancelamento (do pedido até a última tarefa parar), em milissegundos (-1 se nenhum)
+    double cancel_latency = -1;
+
+    // Guarda os blocos (tiles) da imagem do processamento em multi-thread, em ordem de linhas, e o lado e a quantidade por linha deles
+    vector<Region> tiles;
+    int tile_side = DEFAULT_TILE_SIZE;
+    int tiles_per_row = 1;
+
+    // Guarda a faixa de linhas de blocos de cada nó NUMA: o nó k fica com as linhas [node_rows[k], node_rows[k+1])
+    // A saída dessa faixa é tocada primeiro (zerada) e depois filtrada por threads do próprio nó
+    vector<int> node_rows;
+
+    // Guarda o próximo item livre da faixa de cada nó (linha de blocos ao zerar a saída, bloco ao filtrar)
+    // Cada thread pega o próximo item da faixa do seu nó incrementando o contador; quando ela acaba, ajuda as faixas dos outros nós
+    unique_ptr<atomic<int>[]> node_next;
+
+    // Guarda, no filtro gaussiano recursivo, a passada horizontal das linhas inteiras (em float) e a próxima faixa de colunas livre da passada vertical
+    vector<float> recursive_rows;
+    atomic<int> recursive_next_column{0};
+
+    // Guarda o lado dos blocos pedido para o processamento em multi-thread
+    int tile_size = DEFAULT_TILE_SIZE;
+
+    // Guarda a classe de prioridade das tarefas deste processamento no pool de threads
+    TaskPriority priority = TaskPriority::NORMAL;
 
-    // Guarda quantas threads do multithreading já terminaram sua parte do processamento
-    int threads_done = 0;
+    // Guarda quantos blocos cada thread processou no último processamento em multi-thread
+    // (atômicos: as threads incrementam enquanto o servidor lê os contadores para o cabeçalho de progresso)
+    unique_ptr<atomic<int>[]> tiles_per_worker;
+    int tiles_per_worker_count = 0;
+
+    // Guarda os blocos já concluídos de cada saída, para enviar ao frontend só o que mudou
+    // Na saída single-thread, os "blocos" são faixas horizontais, processadas de cima para baixo
+    shared_ptr<DirtyTiles> single_dirty;
+    shared_ptr<DirtyTiles> multi_dirty;
+
+    // Sinal avisado a cada mudança do progresso (bloco concluído, saída concluída, cancelamento), para quem acompanha sem consultar de tempos em tempos
+    shared_ptr<ProgressSignal> progress_signal = make_shared<ProgressSignal>();
+
+    // Guarda cada saída final já codificada, produzida uma única vez quando o processamento dela termina
+    shared_ptr<const EncodedImage> single_encoded;
+    shared_ptr<const EncodedImage> multi_encoded;
 
     // Booleanos para indicar se o processamento em single e multi-threading já foi concluído
-    bool single_thread_ended = false;
-    bool multi_thread_ended = false;
+    atomic<bool> single_thread_ended{false};
+    atomic<bool> multi_thread_ended{false};
 
     // Guarda o tempo de execução do processamento em single e multi-threading
     Timer timer_singleThread;
     Timer timer_multiThread;
 
+    // Modo benchmark: single e multi-thread rodam um depois do outro, com o pool ocioso, em vez de ao mesmo tempo
+    // `benchmark_flush` esvazia os caches antes de cada medida
+    bool benchmark_mode = false;
+    bool benchmark_flush = false;
+
+    // Thread que conduz o benchmark (fixada em um núcleo, roda a versão single-thread e depois inicia a multi-thread)
+    thread benchmark_thread;
+    mutex benchmark_mtx;
+
+    // Speedup (single / multi) e eficiência paralela (speedup / threads) do último benchmark (-1 se não houver)
+    atomic<double> speedup{-1};
+    atomic<double> parallel_efficiency{-1};
+
 public: 
     // Métodos utilizados para o construtor, que inicializa o objeto Image
     Image();
     Image(const string& path, ImageColorType color_type, ImageType type);
     Image(const vector<uchar>& buffer, ImageColorType color_type, ImageType type);
+    Image(const vector<uchar>& buffer, ImageColorType color_type, ImageType type, shared_ptr<ThreadPool> thread_pool);
+    Image(const uchar* data, size_t size, ImageColorType color_type, ImageType type, shared_ptr<ThreadPool> thread_pool);
+    Image(const Mat& decoded, ImageColorType color_type, ImageType type, shared_ptr<ThreadPool> thread_pool);
+    ~Image();
     // Métodos utilizados para sobrescrever a imagem recebida como input
     void overwriteImage(const string& path, ImageColorType color_type, ImageType type);
     void overwriteImage(const vector<uchar>& buffer, ImageColorType color_type, ImageType type);
 
+    /*
+        * Sobrescreve a imagem de entrada decodificando os bytes recebidos diretamente, sem copiá-los
+        * (ex.: do corpo da requisição). Os bytes só precisam existir durante a chamada: não são guardados.
+        * @param data Início dos bytes da imagem codificada (PNG, JPEG, etc.)
+        * @param size Quantidade de bytes
+        * @param color_type Tipo de cor da imagem
+        * @param type Tipo de arquivo da imagem
+        * @returns: void
+    */
+    void overwriteImage(const uchar* data, size_t size, ImageColorType color_type, ImageType type);
+
+    /*
+        * Sobrescreve a imagem de entrada com uma imagem já decodificada e já no tipo de cor `color_type`
+        * (ex.: do cache de imagens enviadas), sem decodificar nem converter de novo.
+        * A matriz é compartilhada, não copiada: a imagem só a lê.
+        * @param decoded Imagem decodificada, no tipo de cor `color_type`
+        * @param color_type Tipo de cor da imagem
+        * @param type Tipo de arquivo da imagem
+        * @returns: void
+    */
+    void overwriteImage(const Mat& decoded, ImageColorType color_type, ImageType type);
+
     // Funções para mostrar e salvar a imagem em um arquivo
     void show();
     void save();
@@ -145,7 +303,7 @@ public:
 
     /*
         * Aplica um filtro de mediana (median) na imagem, utilizado para reduzir ruídos.
-        * Esse filtro demanda mais processamento conforme `intensity` aumenta, pois precisará analisar mais pixels adjacentes e ordená-los.
+        * Usa redes de ordenação para janelas pequenas e histogramas deslizantes para as maiores, com custo constante por pixel.
         * 
         * @param region Região da imagem a ser processada
         * @param image_output Matriz de imagem que recebe o resultado do filtro
@@ -163,15 +321,12 @@ public:
     void grayscale_filter(Region region, Mat& image_output);
 
     /*
-        * Aplica um filtro de máscara (mask) na imagem, utilizando uma máscara personalizada.
+        * Aplica a tabela de consulta `point_lut` na imagem (filtros de gama, contraste e posterização).
         * @param region Região da imagem a ser processada
         * @param image_output Matriz de imagem que recebe o resultado do filtro
-        * @param mask_Mat Máscara a ser aplicada na imagem
-        * @param intensity Intensidade da máscara
-        * @param weight Somatório da máscara
         * @returns: void
     */
-    void apply_mask_filter(Region region, Mat& image_output, Mask_t mask_Mat, int intensity, int weight);
+    void lut_filter(Region region, Mat& image_output);
 
     /*
         * Aplica um filtro gaussiano (gaussian) na imagem, utilizado para suavizar a imagem.
@@ -226,22 +381,132 @@ public:
     // Funções para processar a imagem em single e multi-threading
 
     /*
-        * Processamento da imagem em uma das threads do pool.
-        * Essa função é chamada para cada thread do pool e aplica o filtro na região da imagem correspondente à thread.
-        * Quando a thread termina, ela incrementa o contador de threads concluídas e verifica se todas as threads terminaram.
-        * Se todas as threads terminaram, o booleano `multi_thread_ended` é definido como verdadeiro.
+        * Aplica o filtro na região da imagem, escrevendo na matriz de saída passada.
         * @param filter Filtro a ser aplicado na imagem
-        * @param threads Número de threads disponíveis para o processamento
         * @param region Região da imagem a ser processada
+        * @param image_output Matriz de imagem que recebe o resultado do filtro
+        * @returns: void
+    */
+    void apply_filter(const string& filter, Region region, Mat& image_output);
+
+    /*
+        * Processamento da imagem em uma das threads do pool.
+        * Essa função é chamada para cada thread do processamento em multi-thread: ela pega o próximo bloco livre
+        * da faixa do seu nó NUMA (e, quando ela acaba, das faixas dos outros nós) e aplica o filtro nele, até que não sobre nenhum bloco.
+        * A thread guarda quantos blocos processou. Se a fatia de tempo (TILE_TASK_QUANTUM_US) acabar e houver tarefas
+        * de outros processamentos esperando no pool, ela para antes, para ceder a vez.
+        * No filtro gaussiano recursivo, a fase diz o que a thread pega: linhas de blocos (passada horizontal)
+        * ou faixas de colunas da largura dos blocos (passada vertical, que marca os blocos da faixa como concluídos).
+        * @param filter Filtro a ser aplicado na imagem
+        * @param worker Índice da thread no processamento (0 a threads-1)
+        * @param phase Fase do processamento
+        * @returns: true se parou para ceder a vez (ainda há blocos), false se não sobrou nenhum bloco
+    */
+    bool thread_process(const string& filter, int worker, TilePhase phase);
+
+    /*
+        * Tarefa de blocos de uma thread do processamento em multi-thread, no pool.
+        * Chama `thread_process`; se ela cedeu a vez, a tarefa volta para o fim da fila do pool, atrás das tarefas
+        * de outros processamentos (assim vários processamentos dividem as threads de forma justa).
+        * Quando não sobram blocos, avisa o grupo `multi_thread_group`, que, quando todas as threads terminarem,
+        * para o timer e define o booleano `multi_thread_ended` como verdadeiro.
+        * @param filter Filtro a ser aplicado na imagem
+        * @param worker Índice da thread no processamento (0 a threads-1)
+        * @param group Grupo de espera da fase (o do processamento em multi-thread, na última fase)
+        * @param token Token de cancelamento do processamento
+        * @param phase Fase do processamento
+        * @returns: void
+    */
+    void run_tile_task(const string& filter, int worker, shared_ptr<WaitGroup> group, shared_ptr<CancellationToken> token, TilePhase phase);
+
+    /*
+        * Conduz um processamento no modo benchmark, na thread `benchmark_thread`.
+        * Fixa a thread em um núcleo, espera o pool ficar ocioso (até BENCHMARK_QUIESCE_TIMEOUT_MS), roda a versão
+        * single-thread nela mesma e só depois inicia a versão multi-thread no pool.
+        * Se `benchmark_flush` for verdadeiro, esvazia os caches antes de cada uma.
+        * O speedup e a eficiência são calculados quando a versão multi-thread termina (continuação de `multi_thread_group`).
+        * @param run_single Processamento em single-thread (avisa `single_thread_group` ao terminar)
+        * @param start_multi Inicia o processamento em multi-thread (que avisa `multi_thread_group` ao terminar)
+        * @param token Token de cancelamento do processamento
+        * @returns: void
+    */
+    void run_benchmark(function<void()> run_single, function<void()> start_multi, shared_ptr<CancellationToken> token);
+
+    /*
+        * Codifica uma imagem de saída no formato da imagem de entrada (convertendo de HSV para BGR, se preciso).
+        * @param output Imagem de saída
+        * @returns: bytes codificados
+    */
+    vector<uchar> encode_output(const Mat& output);
+
+    /*
+        * Codifica uma imagem de saída final e calcula a ETag dela (hash do conteúdo codificado).
+        * @param output Imagem de saída
+        * @returns: imagem codificada com a ETag
+    */
+    shared_ptr<const EncodedImage> make_encoded(const Mat& output);
+
+    /*
+        * Prepara as tabelas e os kernels usados pelos filtros (chamada por todos os construtores).
+        * Cada um é montado uma única vez por processo; as chamadas seguintes não fazem nada.
+        * @returns: void
+    */
+    static void init_kernels();
+
+    /*
+        * Esvazia os caches da CPU atual, lendo e escrevendo um buffer com o dobro do tamanho do maior cache.
+        * Para antes se o processamento da thread atual for cancelado.
+        * @returns: void
+    */
+    static void flush_caches();
+
+    /*
+        * Primeiro toque da saída do processamento em multi-thread, feito pelas threads do pool antes de filtrar.
+        * Cada thread zera as linhas de blocos da faixa do seu nó NUMA, para que as páginas de memória dessas linhas
+        * sejam alocadas no nó das threads que vão escrever nelas.
         * @returns: void
     */
-    void thread_process(const string& filter, int threads, Region region);
+    void first_touch_process();
+
+    /*
+        * Pega o próximo item livre, começando pela faixa do nó `node` e passando às faixas dos outros nós quando ela acaba.
+        * @param node Nó NUMA da thread
+        * @param scale Itens por linha de blocos (1 para linhas de blocos, `tiles_per_row` para blocos)
+        * @returns: índice do item, ou -1 se não sobrar nenhum
+    */
+    int claim_work(int node, int scale);
+
+    /*
+        * Divide as linhas de blocos entre os nós NUMA, proporcionalmente às threads do pool em cada nó, e zera os contadores.
+        * @returns: void
+    */
+    void split_tiles_by_node();
+
+    /*
+        * Retorna a margem de vizinhança que o filtro processa em volta de cada bloco.
+        * Os blocos têm lado de pelo menos 4 vezes essa margem, para que o trabalho repetido nas margens fique pequeno.
+        * @param filter Filtro a ser aplicado na imagem
+        * @returns: margem em pixels
+    */
+    int tile_halo(const string& filter);
+
+    /*
+        * Retorna o kernel do filtro gaussiano se ele usar a versão recursiva (aritmética float e raio de pelo menos
+        * RECURSIVE_GAUSSIAN_MIN_RADIUS). Nesse caso o filtro não é aplicado por blocos: o processamento roda
+        * a passada horizontal em linhas inteiras e só depois a vertical em colunas inteiras.
+        * @param filter Filtro a ser aplicado na imagem
+        * @returns: kernel 1D, ou nullptr se o filtro não usar a versão recursiva
+    */
+    const vector<float>* recursive_gaussian_kernel(const string& filter);
 
     /*
         * Processamento da imagem em uma única thread.
-        * Essa função aplica o filtro na imagem inteira e armazena o resultado na matriz `image_singleThread`.
-        * O tempo de execução é medido e armazenado na variável `timer_singleThread`.
-        * Quando o processamento termina, o booleano `single_thread_ended` é definido como verdadeiro.
+        * Essa função aplica o filtro na região e armazena o resultado na matriz `image_singleThread`.
+        * A região é processada em faixas horizontais da altura dos blocos, de cima para baixo, e cada faixa concluída
+        * é marcada em `single_dirty`, para que o frontend acompanhe o progresso. No filtro gaussiano recursivo, a imagem inteira
+        * passa pela passada horizontal e depois pela vertical, e as faixas só são marcadas no fim.
+        * Quem chama avisa o grupo `single_thread_group`, que para o timer `timer_singleThread`
+        * e define o booleano `single_thread_ended` como verdadeiro.
         * @param filter Filtro a ser aplicado na imagem
         * @param region Região da imagem a ser processada
         * @returns: void
@@ -250,31 +515,130 @@ public:
 
     /*
         * Esta função é chamada para processar a imagem em múltiplas threads e em uma única thread.
-        * Ela divide a imagem em regiões e chama a função `thread_process` para cada região.
+        * Ela divide a imagem em blocos e chama a função `thread_process` uma vez por thread; as threads dividem os blocos entre si dinamicamente.
         * Em paralelo, ela chama a função `single_thread_process` para processar a imagem inteira em uma única thread.
         * @param filter Filtro a ser aplicado na imagem
         * @param intensity Intensidade do filtro (1-10)
         * @param threads número de threads escolhido para o processamento
+        * @param path Aritmética das convoluções (float ou ponto fixo)
+        * @returns: void
+    */
+    void process (const string& filter, int intensity, int threads, ConvolutionPath path);
+
+    /*
+        * Define o lado dos blocos (tiles) usados no processamento em multi-thread.
+        * @param size Lado dos blocos em pixels (mínimo 8)
+        * @returns: void
+    */
+    void set_tile_size(int size);
+
+    /*
+        * Define a classe de prioridade das tarefas dos próximos processamentos no pool de threads
+        * (ex.: INTERACTIVE para um usuário esperando na tela, BATCH para processamentos em lote).
+        * @param priority Classe de prioridade
+        * @returns: void
+    */
+    void set_priority(TaskPriority priority);
+
+    /*
+        * Liga ou desliga o modo benchmark dos próximos processamentos: a versão single-thread roda primeiro, sozinha,
+        * em uma thread fixada em um núcleo, e a multi-thread só depois, no pool ocioso, para que uma não atrapalhe a medida da outra.
+        * @param enabled Se o modo benchmark fica ligado
+        * @param flush_caches Se os caches são esvaziados antes de cada medida
+        * @returns: void
+    */
+    void set_benchmark(bool enabled, bool flush_caches);
+
+    /*
+        * Cancela o processamento atual (se ainda não terminou) e espera as tarefas dele pararem.
+        * As tarefas param na próxima linha ou bloco, então a espera é curta. Depois disso é seguro
+        * trocar a imagem de entrada e realocar as imagens de saída.
         * @returns: void
     */
-    void process (const string& filter, int intensity, int threads);
+    void cancel_processing();
+
+    /*
+        * Retorna a latência do último cancelamento: o tempo entre o pedido e a última tarefa do processamento cancelado parar.
+        * @returns: latência em milissegundos, ou -1 se nenhum processamento foi cancelado
+    */
+    double get_cancel_latency();
 
     // Funções para retornar informações sobre a imagem processada
 
+    /*
+        * Retorna quantos blocos cada thread processou no último processamento em multi-thread.
+        * @returns: vetor com a quantidade de blocos de cada thread
+    */
+    vector<int> get_tiles_per_worker();
+
+    /*
+        * Retorna os blocos de uma saída concluídos depois do número de sequência `since`, cada um codificado em PNG.
+        * Cada bloco é codificado uma única vez, na primeira consulta que o retorna; as seguintes reaproveitam os bytes.
+        * @param multi Saída multi-thread (true) ou single-thread (false)
+        * @param since Maior número de sequência que quem consulta já viu (0 na primeira consulta)
+        * @param sequence Recebe o número de sequência atual, a ser passado como `since` na próxima consulta
+        * @returns: blocos que mudaram, em ordem de conclusão
+    */
+    vector<TileUpdate> get_tile_updates(bool multi, uint64_t since, uint64_t& sequence);
+
+    /*
+        * Retorna os blocos de uma saída concluídos depois do número de sequência `since`, com a thread que processou cada um
+        * (sem codificá-los).
+        * @param multi Saída multi-thread (true) ou single-thread (false)
+        * @param since Maior número de sequência que quem consulta já viu (0 na primeira consulta)
+        * @param sequence Recebe o número de sequência atual, que é também a quantidade de blocos concluídos
+        * @param total Recebe a quantidade total de blocos da saída
+        * @returns: blocos concluídos, em ordem de conclusão
+    */
+    vector<TileCompletion> get_tile_completions(bool multi, uint64_t since, uint64_t& sequence, int& total);
+
+    /*
+        * Retorna o sinal de progresso, avisado a cada bloco concluído, saída concluída ou cancelamento.
+        * @returns: sinal de progresso
+    */
+    shared_ptr<ProgressSignal> get_progress_signal();
+
+    /*
+        * Retorna se o processamento atual foi cancelado (ex.: substituído por outro job do mesmo usuário).
+        * @returns: true se foi cancelado
+    */
+    bool is_cancelled();
+
+    /*
+        * Retorna a largura da imagem em pixels.
+        * @returns: largura
+    */
+    int get_width();
+
+    /*
+        * Retorna a altura da imagem em pixels.
+        * @returns: altura
+    */
+    int get_height();
+
     /*
         * Retorna o tipo de imagem (JPEG, PNG, etc.) como string.
         * @returns: string com o tipo de imagem
     */
     string get_image_type();
 
+    /*
+        * Retorna a saída final já codificada, com a ETag, produzida uma única vez quando o processamento terminou.
+        * @param multi Saída multi-thread (true) ou single-thread (false)
+        * @returns: imagem codificada, ou nullptr se o processamento dessa saída ainda não terminou
+    */
+    shared_ptr<const EncodedImage> get_encoded_result(bool multi);
+
     /*
         * Retorna a matriz de imagem processada em uma única thread como um vetor de bytes.
+        * Depois que o processamento termina, retorna a cópia já codificada, sem codificar de novo.
         * @returns: vetor de bytes com a imagem processada
     */
     vector<uchar> get_single_thread_image();
 
     /*
         * Retorna a matriz de imagem processada em múltiplas threads como um vetor de bytes.
+        * Depois que o processamento termina, retorna a cópia já codificada, sem codificar de novo.
         * @returns: vetor de bytes com a imagem processada
     */
     vector<uchar> get_multi_thread_image();
@@ -291,6 +655,21 @@ public:
     */
     bool get_multi_thread_done();
 
+    /*
+        * Espera o processamento em uma única thread terminar, por no máximo `timeout_ms` milissegundos.
+        * @param timeout_ms Tempo máximo de espera em milissegundos
+        * @returns: booleano indicando se o processamento foi concluído
+    */
+    bool wait_single_thread(int timeout_ms);
+
+    /*
+        * Espera o processamento em múltiplas threads terminar, por no máximo `timeout_ms` milissegundos.
+        * Retorna assim que o último bloco for processado.
+        * @param timeout_ms Tempo máximo de espera em milissegundos
+        * @returns: booleano indicando se o processamento foi concluído
+    */
+    bool wait_multi_thread(int timeout_ms);
+
     /*
         * Retorna a duração do processamento em uma única thread em milissegundos.
         * Se o processamento ainda não foi concluído, retorna o tempo decorrido até o momento.
@@ -306,11 +685,32 @@ public:
         * @returns: duração do processamento em milissegundos
     */
     double get_multi_thread_duration(bool);
+
+    /*
+        * Retorna o speedup do último processamento no modo benchmark: duração single-thread / duração multi-thread.
+        * @returns: speedup, ou -1 se o processamento não foi no modo benchmark ou ainda não terminou
+    */
+    double get_speedup();
+
+    /*
+        * Retorna a eficiência paralela do último processamento no modo benchmark: speedup / quantidade de threads.
+        * @returns: eficiência (1 = ideal), ou -1 se o processamento não foi no modo benchmark ou ainda não terminou
+    */
+    double get_parallel_efficiency();
 };
 
 // DA CLASSE //////////////////////////////////
+void Image::
+    init_kernels() {
+        GaussianKernelTable::instance(); // pré-calcula os kernels gaussianos
+        point_kernels(); // escolhe os kernels vetorizados de acordo com a CPU
+        fixed_point_kernels();
+        lut_kernels();
+    }
+
 Image::
-    Image() : thread_pool(make_unique<ThreadPool>(11)) { 
+    Image() : thread_pool(make_shared<ThreadPool>(effective_cpu_count(), pin_threads_from_env())) { 
+        init_kernels();
         this->path = "none";
         this->color_type = ImageColorType::RGB;
         this->type = ImageType::JPEG;
@@ -320,12 +720,15 @@ Image::
 
 
 Image::
-    Image(const string& path, ImageColorType color_type, ImageType type): thread_pool(make_unique<ThreadPool>(11)) {
+    Image(const string& path, ImageColorType color_type, ImageType type): thread_pool(make_shared<ThreadPool>(effective_cpu_count(), pin_threads_from_env())) {
+        init_kernels();
         overwriteImage(path, color_type, type);
     }
 void Image::
     overwriteImage(const string& path, ImageColorType color_type, ImageType type) {
-        
+        // As tarefas de um processamento anterior ainda leem a imagem atual
+        this->cancel_processing();
+
         this->path = path;
         this->color_type = color_type;
         this->type = type;
@@ -348,41 +751,74 @@ void Image::
 
         // Verifica se a imagem foi carregada corretamente
         if (this->image.empty()) {
-            cerr << "Erro: falha ao decodificar imagem!" << endl;
-            exit(EXIT_FAILURE);
+            throw invalid_argument("Erro: falha ao decodificar imagem!");
         }
 
         this->width = image.cols;
         this->height = image.rows;
+
+        // Monta a cópia com borda de zeros uma única vez por imagem recebida
+        this->image_padded.build(this->image, MAX_FILTER_RADIUS);
+    }
+
+Image::
+    Image(const vector<uchar>& buffer, ImageColorType color_type, ImageType type): Image(buffer, color_type, type, make_shared<ThreadPool>(effective_cpu_count(), pin_threads_from_env())) {}
+
+Image::
+    Image(const vector<uchar>& buffer, ImageColorType color_type, ImageType type, shared_ptr<ThreadPool> thread_pool): Image(buffer.data(), buffer.size(), color_type, type, thread_pool) {}
+
+Image::
+    Image(const uchar* data, size_t size, ImageColorType color_type, ImageType type, shared_ptr<ThreadPool> thread_pool): thread_pool(thread_pool) { 
+        init_kernels();
+        overwriteImage(data, size, color_type, type);
+    }
+
+Image::
+    Image(const Mat& decoded, ImageColorType color_type, ImageType type, shared_ptr<ThreadPool> thread_pool): thread_pool(thread_pool) { 
+        init_kernels();
+        overwriteImage(decoded, color_type, type);
     }
 
+// Com o pool compartilhado, as tarefas da imagem podem sobreviver a ela: cancela e espera antes de destruir
 Image::
-    Image(const vector<uchar>& buffer, ImageColorType color_type, ImageType type): thread_pool(make_unique<ThreadPool>(11)) { 
-        overwriteImage(buffer, color_type, type);
+    ~Image() {
+        this->cancel_processing();
     }
 void Image::
     overwriteImage(const vector<uchar>& buffer, ImageColorType color_type, ImageType type) {
+        this->overwriteImage(buffer.data(), buffer.size(), color_type, type);
+    }
+
+void Image::
+    overwriteImage(const uchar* data, size_t size, ImageColorType color_type, ImageType type) {
+        // As tarefas de um processamento anterior ainda leem a imagem atual
+        this->cancel_processing();
 
-        this->buffer = buffer;
         this->color_type = color_type;
         this->type = type;
 
         // se o buffer estiver vazio
-        if (buffer.empty()) { 
+        if (data == nullptr || size == 0) { 
             throw invalid_argument("Erro: buffer de imagem vazio!");
         }
+        if (size > (size_t) INT_MAX) {
+            throw invalid_argument("Erro: imagem grande demais!");
+        }
+
+        // Matriz que só aponta para os bytes recebidos (sem cópia), lida diretamente pelo imdecode
+        const Mat encoded(1, (int) size, CV_8UC1, const_cast<uchar*>(data));
 
         // trata a interpretação de cor da imagem de acordo com o especificado
         switch(this->color_type){
             case ImageColorType::RGB:
-                this->image = imdecode(buffer, IMREAD_COLOR);
+                this->image = imdecode(encoded, IMREAD_COLOR);
                 break;
             case ImageColorType::HSV:
-                this->image = imdecode(buffer, IMREAD_COLOR);
+                this->image = imdecode(encoded, IMREAD_COLOR);
                 cvtColor(this->image, this->image, COLOR_BGR2HSV);
                 break;
             case ImageColorType::GRAYSCALE:
-                this->image = imdecode(buffer, IMREAD_GRAYSCALE);
+                this->image = imdecode(encoded, IMREAD_GRAYSCALE);
                 break;
             default:
                 throw invalid_argument("Erro: tipo de cor inválido!");
@@ -390,12 +826,38 @@ void Image::
 
         // Verifica se a imagem foi carregada corretamente
         if (this->image.empty()) {
-            cerr << "Erro: falha ao decodificar imagem!" << endl;
-            exit(EXIT_FAILURE);
+            throw invalid_argument("Erro: falha ao decodificar imagem!");
+        }
+
+        this->width = image.cols;
+        this->height = image.rows;
+
+        // Monta a cópia com borda de zeros uma única vez por imagem recebida
+        this->image_padded.build(this->image, MAX_FILTER_RADIUS);
+    }
+
+void Image::
+    overwriteImage(const Mat& decoded, ImageColorType color_type, ImageType type) {
+        // As tarefas de um processamento anterior ainda leem a imagem atual
+        this->cancel_processing();
+
+        if (decoded.empty()) {
+            throw invalid_argument("Erro: imagem decodificada vazia!");
         }
+        int expected_channels = color_type == ImageColorType::GRAYSCALE ? 1 : 3;
+        if (decoded.type() != CV_8UC(expected_channels)) {
+            throw invalid_argument("Erro: imagem decodificada não corresponde ao tipo de cor!");
+        }
+
+        this->color_type = color_type;
+        this->type = type;
+        this->image = decoded;
 
         this->width = image.cols;
         this->height = image.rows;
+
+        // Monta a cópia com borda de zeros uma única vez por imagem recebida
+        this->image_padded.build(this->image, MAX_FILTER_RADIUS);
     }
 
 void Image::
@@ -535,45 +997,22 @@ inline float normalizeInInterval(int value, Interval& interval){
 // FILTROS //////////////////////////////////
 void Image::
     negative_filter(Region region, Mat& image_output) {
-
-        // Se a imagem for BGR, aplica o filtro em cada canal
-        if (this->color_type == ImageColorType::RGB){
-            for (int i = region.x_begin; i <= region.x_end; i++){
-                for (int j = region.y_begin; j <= region.y_end; j++){
-
-                    // Pega o pixel da imagem de saída
-                    Vec3b& pixel = image_output.at<Vec3b>(j, i);
-
-                    // Aplica o filtro negativo em cada canal
-                    pixel[0] = 255 - this->image.at<Vec3b>(j, i)[0]; // B
-                    pixel[1] = 255 - this->image.at<Vec3b>(j, i)[1]; // G
-                    pixel[2] = 255 - this->image.at<Vec3b>(j, i)[2]; // R
-                }
-            }
-        } else // se a imagem for HSV, aplica o filtro no canal de Valor
-        if(this->color_type == ImageColorType::HSV){
-            for (int i = region.x_begin; i <= region.x_end; i++){
-                for (int j = region.y_begin; j <= region.y_end; j++){
-
-                    // Pega o pixel da imagem de saída
-                    Vec3b& pixel = image_output.at<Vec3b>(j, i);
-
-                    // Aplica o filtro negativo em cada canal
-                    pixel[0] = (this->image.at<Vec3b>(j, i)[0] + 90) % 180 ;    // H (girar "180 graus")
-                    pixel[1] = 255 - this->image.at<Vec3b>(j, i)[1];            // S
-                    pixel[2] = 255 - this->image.at<Vec3b>(j, i)[2];            // V
-                }
-            }  
-        }else { // imagem em tons de cinza
-            for (int i = region.x_begin; i <= region.x_end; i++){
-                for (int j = region.y_begin; j <= region.y_end; j++){
-
-                    // aplica o filtro negativo no canal único
-                    image_output.at<uchar>(j, i) = 255 - this->image.at<uchar>(j, i);
-                }
-            }
-        }
-
+        const PointKernels& kernels = point_kernels();
+        int cn = this->image.channels();
+        int n = region.x_end - region.x_begin + 1;
+
+        // Percorre a região linha a linha, aplicando o kernel vetorizado no trecho contínuo de cada linha
+        for_each_row(region, [&](int j, int x_begin, int) {
+            const uchar* input_row = this->image.ptr<uchar>(j) + x_begin * cn;
+            uchar* output_row = image_output.ptr<uchar>(j) + x_begin * cn;
+
+            // se a imagem for HSV, gira o H e inverte S e V
+            if (this->color_type == ImageColorType::HSV)
+                kernels.negative_hsv(input_row, output_row, n);
+            // se a imagem for BGR ou em tons de cinza, inverte todos os canais (byte a byte)
+            else
+                kernels.invert(input_row, output_row, n * cn);
+        });
     }
 
 void Image::
@@ -582,1213 +1021,584 @@ void Image::
         Interval interval = {0, 255};
         float normalized_intensity = normalizeInInterval(intensity, interval);
 
-        // Se a imagem for BGR, aplica o filtro em cada canal
-        if (this->color_type == ImageColorType::RGB){
-            for (int i = region.x_begin; i <= region.x_end; i++){
-                for (int j = region.y_begin; j <= region.y_end; j++){
-
-                    // Pega o pixel da imagem de saída
-                    Vec3b& pixel = image_output.at<Vec3b>(j, i);
-
-                    int thresholding_value = (this->image.at<Vec3b>(j, i)[0] + this->image.at<Vec3b>(j, i)[1] + this->image.at<Vec3b>(j, i)[2]) / 3;
-                    
-                    // Aplica o filtro de limiarização
-                    if (thresholding_value < normalized_intensity) {
-                        pixel[0] = 0; // B
-                        pixel[1] = 0; // G
-                        pixel[2] = 0; // R
-                    } else {
-                        pixel[0] = 255; // B
-                        pixel[1] = 255; // G
-                        pixel[2] = 255; // R
-                    }
-                }
-            }
-        } else // se a imagem for HSV, aplica o filtro no canal de Valor
-        if(this->color_type == ImageColorType::HSV){
-            for (int i = region.x_begin; i <= region.x_end; i++){
-                for (int j = region.y_begin; j <= region.y_end; j++){
-
-                    // Pega o pixel da imagem de saída
-                    Vec3b& pixel = image_output.at<Vec3b>(j, i);
-
-                    // Aplica o filtro de limiarização
-                    if (this->image.at<Vec3b>(j, i)[2] < normalized_intensity) {
-                        pixel[2] = 0; // V
-                    } else {
-                        pixel[2] = 255; // V
-                    }
-                }
-            }  
-        }else { // imagem em tons de cinza
-            for (int i = region.x_begin; i <= region.x_end; i++){
-                for (int j = region.y_begin; j <= region.y_end; j++){
-
-                    // Pega o pixel da imagem de saída
-                    uchar thresholding_value = this->image.at<uchar>(j, i);
-
-                    // Aplica o filtro de limiarização
-                    if (thresholding_value < normalized_intensity) {
-                        image_output.at<uchar>(j, i) = 0; // Preto
-                    } else {
-                        image_output.at<uchar>(j, i) = 255; // Branco
-                    }
-                }
-            }
-        }
-
+        // Como os pixels são inteiros, valor < limiar  <=>  valor < ceil(limiar)
+        int threshold = (int) ceil(normalized_intensity);
+
+        const PointKernels& kernels = point_kernels();
+        int cn = this->image.channels();
+        int n = region.x_end - region.x_begin + 1;
+
+        for_each_row(region, [&](int j, int x_begin, int) {
+            const uchar* input_row = this->image.ptr<uchar>(j) + x_begin * cn;
+            uchar* output_row = image_output.ptr<uchar>(j) + x_begin * cn;
+
+            // Se a imagem for BGR, usa a média dos canais
+            if (this->color_type == ImageColorType::RGB)
+                kernels.threshold_bgr(input_row, output_row, n, threshold);
+            // se a imagem for HSV, aplica o filtro no canal de Valor
+            else if (this->color_type == ImageColorType::HSV)
+                kernels.threshold_hsv(input_row, output_row, n, threshold);
+            // imagem em tons de cinza
+            else
+                kernels.threshold_gray(input_row, output_row, n, threshold);
+        });
     }
 
 void Image::
     blur_filter(Region region, Mat& image_output, int intensity){
 
-        // se a imagem for BGR, aplica o filtro em cada canal
-        if (this->color_type == ImageColorType::RGB) {
-
-            // Para cada pixel da imagem, aplica o filtro
-            for (int i = region.x_begin; i <= region.x_end; i++) {
-                for (int j = region.y_begin; j <= region.y_end; j++) {
-                    int meanValue[] = {0, 0, 0};
-
-                    // Para cada pixel vizinho, soma os valores dos pixels vizinhos em cada canal
-                    for (int k = -intensity; k <= intensity; k++) {
-                        for (int l = -intensity; l <= intensity; l++) {
-                            // Pega o pixel vizinho
-                            int x = i + k;
-                            int y = j + l;
-
-                            // Ignora pixels fora da imagem (mesma coisa que somar com 0, ou seja, usar o zero-padding)
-                            if (x < 0 || x >= this->width || y < 0 || y >= this->height) {
-                                continue;
-                            }
-
-                            // soma os valores dos pixels vizinhos em cada canal, usando ptr<> para acessar os pixels rapidamente
-                            const Vec3b* input_row = this->image.ptr<Vec3b>(y);
-                            meanValue[0] += input_row[x][0]; // B
-                            meanValue[1] += input_row[x][1]; // G
-                            meanValue[2] += input_row[x][2]; // R
-                        }
-                    }
+        // Quantidade de pixels da janela (incluindo os de fora da imagem, que contam como zero)
+        int area = (intensity * 2 + 1) * (intensity * 2 + 1);
+
+        // se a imagem for BGR ou em tons de cinza, aplica o filtro em todos os canais
+        // se a imagem for HSV, aplica o filtro no canal de Valor
+        int only_channel = (this->color_type == ImageColorType::HSV) ? 2 : -1;
+        int cn = this->image.channels();
 
-                    Vec3b* output_row = image_output.ptr<Vec3b>(j);
+        // Soma das janelas calculada com somas deslizantes, O(1) por pixel independente da intensidade
+        box_sum_rows(this->image_padded, region, intensity, only_channel, [&](int y, const int* sums) {
+            const uchar* input_row = this->image.ptr<uchar>(y);
+            uchar* output_row = image_output.ptr<uchar>(y);
 
-                    // Define o pixel da imagem de saída como a média dos pixels vizinhos
-                    output_row[i][0] = round(meanValue[0] / ((intensity * 2 + 1) * (intensity * 2 + 1))); // B
-                    output_row[i][1] = round(meanValue[1] / ((intensity * 2 + 1) * (intensity * 2 + 1))); // G
-                    output_row[i][2] = round(meanValue[2] / ((intensity * 2 + 1) * (intensity * 2 + 1))); // R
+            for (int x = region.x_begin; x <= region.x_end; x++) {
+                int i = x - region.x_begin;
+
+                if (only_channel < 0) {
+                    // define o pixel da imagem de saída como a média dos pixels vizinhos em cada canal
+                    for (int c = 0; c < cn; c++) {
+                        output_row[x * cn + c] = sums[i * cn + c] / area;
+                    }
+                } else {
+                    output_row[x * cn + 0] = input_row[x * cn + 0]; // H (mantém o mesmo valor)
+                    output_row[x * cn + 1] = input_row[x * cn + 1]; // S (mantém o mesmo valor)
+                    output_row[x * cn + 2] = sums[i] / area;        // V
                 }
             }
+        });
+    }
 
-        } else  // se a imagem for HSV, aplica o filtro no canal de Valor
-        if (this->color_type == ImageColorType::HSV) {
 
-            // Para cada pixel da imagem, aplica o filtro
-            for (int i = region.x_begin; i <= region.x_end; i++) {
-                for (int j = region.y_begin; j <= region.y_end; j++) {
-                    int meanValue = 0;
+void Image::
+    sharpen_filter(Region region, Mat& image_output, int intensity){
 
-                    // Para cada pixel vizinho, soma os valores dos pixels vizinhos no canal de Valor
-                    for (int k = -intensity; k <= intensity; k++) {
-                        for (int l = -intensity; l <= intensity; l++) {
-                            // Pega o pixel vizinho
-                            int x = i + k;
-                            int y = j + l;
+        Interval interval = {1, 3};
+        float k = normalizeInInterval(intensity, interval); // Normaliza a intensidade para o intervalo [1, 3]
+    
+        int meanFilterIntensity = 5; // Intensidade do filtro de média (um valor fixo)
+        int area = (meanFilterIntensity * 2 + 1) * (meanFilterIntensity * 2 + 1);
 
-                            // Ignora pixels fora da imagem (mesma coisa que somar com 0, ou seja, usar o zero-padding)
-                            if (x < 0 || x >= this->width || y < 0 || y >= this->height) {
-                                continue;
-                            }
+        // Se a imagem for BGR ou em tons de cinza, aplica o filtro em todos os canais
+        // Se a imagem for HSV, aplica o filtro no canal de Valor
+        int only_channel = (this->color_type == ImageColorType::HSV) ? 2 : -1;
+        int cn = this->image.channels();
 
-                            const Vec3b* input_row = this->image.ptr<Vec3b>(y); // Usando ptr<> para acessar a linha de pixels
+        // A média local vem do mesmo motor de somas deslizantes usado no blur
+        box_sum_rows(this->image_padded, region, meanFilterIntensity, only_channel, [&](int y, const int* sums) {
+            const uchar* input_row = this->image.ptr<uchar>(y);
+            uchar* output_row = image_output.ptr<uchar>(y);
 
-                            // soma os valores dos pixels vizinhos no canal de Valor
-                            meanValue += input_row[x][2]; // V
-                        }
-                    }
+            for (int x = region.x_begin; x <= region.x_end; x++) {
+                int i = x - region.x_begin;
 
-                    Vec3b* output_row = image_output.ptr<Vec3b>(j);
+                if (only_channel < 0) {
+                    for (int c = 0; c < cn; c++) {
+                        // Calcula a mascara de nitidez no pixel atual
+                        float gMask = input_row[x * cn + c] - (sums[i * cn + c] / area);
 
-                    output_row[i][0] = this->image.ptr<Vec3b>(j)[i][0]; // H (mantém o mesmo valor)
-                    output_row[i][1] = this->image.ptr<Vec3b>(j)[i][1]; // S (mantém o mesmo valor)
+                        // Aplica o filtro de nitidez com intensidade k, evitando overflow com a função clamp
+                        output_row[x * cn + c] = clamp((double) round(input_row[x * cn + c] + k * gMask), 0.0, 255.0);
+                    }
+                } else {
+                    float gMask = input_row[x * cn + 2] - (sums[i] / area); // V
 
-                    // define o pixel da imagem de saída como a média dos pixels vizinhos
-                    output_row[i][2] = round(meanValue / ((intensity * 2 + 1) * (intensity * 2 + 1))); // V
+                    output_row[x * cn + 0] = input_row[x * cn + 0]; // H (mantém o mesmo valor)
+                    output_row[x * cn + 1] = input_row[x * cn + 1]; // S (mantém o mesmo valor)
+                    output_row[x * cn + 2] = clamp((double) round(input_row[x * cn + 2] + k * gMask), 0.0, 255.0); // V
                 }
             }
+        });
+    }    
 
-        } else { // se a imagem for em tons de cinza, aplica no canal único
-
-            // Para cada pixel da imagem, aplica o filtro
-            for (int i = region.x_begin; i <= region.x_end; i++) {
-                for (int j = region.y_begin; j <= region.y_end; j++) {
-                    int meanValue = 0;
-
-                    // Para cada pixel vizinho, soma os valores dos pixels vizinhos no canal único
-                    for (int k = -intensity; k <= intensity; k++) {
-                        for (int l = -intensity; l <= intensity; l++) {
-                            // Pega o pixel vizinho
-                            int x = i + k;
-                            int y = j + l;
-
-                            // Ignora pixels fora da imagem (mesma coisa que somar com 0, ou seja, usar o zero-padding)
-                            if (x < 0 || x >= this->width || y < 0 || y >= this->height) {
-                                continue;
-                            }
-
-                            // soma os valores dos pixels vizinhos no canal único, usando ptr<> para acessar os pixels rapidamente
-                            const uchar* input_row = this->image.ptr<uchar>(y);
-                            meanValue += input_row[x];
-                        }
-                    }
 
-                    uchar* output_row = image_output.ptr<uchar>(j);
+void Image::
+    median_filter(Region region, Mat& image_output, int intensity) {
+
+        // Se a imagem for BGR, aplica o filtro em cada canal
+        if(this->color_type == ImageColorType::RGB){
+            for (int c = 0; c < 3; c++) {
+                median_channel(this->image, image_output, region, intensity, c);
+            }
+
+        // Caso em que é pra imagem resultado ser HSV
+        }else 
+        if(this->color_type == ImageColorType::HSV){
 
-                    // define o pixel da imagem de saída como a média dos pixels vizinhos
-                    output_row[i] = round(meanValue / ((intensity * 2 + 1) * (intensity * 2 + 1)));
+            // H e S mantêm o mesmo valor
+            for_each_row(region, [&](int j, int x_begin, int x_end) {
+                const Vec3b* input_row = this->image.ptr<Vec3b>(j);
+                Vec3b* output_row = image_output.ptr<Vec3b>(j);
+                for (int i = x_begin; i <= x_end; i++) {
+                    output_row[i][0] = input_row[i][0]; // H
+                    output_row[i][1] = input_row[i][1]; // S
                 }
-            }
+            });
+
+            // Aplica o filtro de mediana no canal de Valor
+            median_channel(this->image, image_output, region, intensity, 2);
+
+        // Caso em que é pra imagem resultado ser em tons de cinza
+        } else {
+            median_channel(this->image, image_output, region, intensity, 0);
         }
     }
 
-
 void Image::
-    sharpen_filter(Region region, Mat& image_output, int intensity){
+    grayscale_filter(Region region, Mat& image_output) {
 
-        Interval interval = {1, 3};
-        float k = normalizeInInterval(intensity, interval); // Normaliza a intensidade para o intervalo [1, 3]
-    
-        int meanFilterIntensity = 5; // Intensidade do filtro de média (um valor fixo)
-    
-        // Se a imagem for BGR, aplica o filtro em cada canal
-        if (this->color_type == ImageColorType::RGB) {
-    
-            // Para cada pixel da imagem, aplica o filtro
-            for (int i = region.x_begin; i <= region.x_end; i++) {
-                for (int j = region.y_begin; j <= region.y_end; j++) {
-                    int meanValue[] = {0, 0, 0};
+        // imagem em tons de cinza já está em escala de cinza
+        if (this->color_type == ImageColorType::GRAYSCALE) return;
+
+        const PointKernels& kernels = point_kernels();
+        int n = region.x_end - region.x_begin + 1;
+
+        for_each_row(region, [&](int j, int x_begin, int) {
+            const uchar* input_row = this->image.ptr<uchar>(j) + x_begin * 3;
+            uchar* output_row = image_output.ptr<uchar>(j) + x_begin * 3;
+
+            // Se a imagem for BGR, o canal azul tem peso 0.114, o verde 0.587 e o vermelho 0.299
+            if (this->color_type == ImageColorType::RGB)
+                kernels.grayscale_bgr(input_row, output_row, n);
+            // Caso em que é pra imagem resultado ser HSV
+            // Define a saturacao como 0, pois remove qualquer perceptibilidade de cor
+            // Os canais H e V mantêm-se os mesmos, pois a intensidade eh dada pelo canal de Valor
+            else
+                kernels.grayscale_hsv(input_row, output_row, n);
+        });
+    }
     
-                    // Para cada pixel vizinho, soma os valores dos pixels vizinhos em cada canal
-                    for (int k = -meanFilterIntensity; k <= meanFilterIntensity; k++) {
-                        for (int l = -meanFilterIntensity; l <= meanFilterIntensity; l++) {
-                            // Pega o pixel vizinho
-                            int x = i + k;
-                            int y = j + l;
-    
-                            // Ignora pixels fora da imagem (mesma coisa que somar com 0, ou seja, usar o zero-padding)
-                            if (x < 0 || x >= this->width || y < 0 || y >= this->height) {
-                                continue;
-                            }
-    
-                            const Vec3b* input_row = this->image.ptr<Vec3b>(y); // Usando ptr<> para acessar a linha de pixels
-                            meanValue[0] += input_row[x][0]; // B
-                            meanValue[1] += input_row[x][1]; // G
-                            meanValue[2] += input_row[x][2]; // R
-                        }
-                    }
-    
-                    // Calcula a mascara de nitidez no pixel atual para cada canal
-                    float gMask[] = {0, 0, 0};
-                    gMask[0] = (this->image.ptr<Vec3b>(j)[i][0]) - (meanValue[0] / ((meanFilterIntensity * 2 + 1) * (meanFilterIntensity * 2 + 1))); // B
-                    gMask[1] = (this->image.ptr<Vec3b>(j)[i][1]) - (meanValue[1] / ((meanFilterIntensity * 2 + 1) * (meanFilterIntensity * 2 + 1))); // G
-                    gMask[2] = (this->image.ptr<Vec3b>(j)[i][2]) - (meanValue[2] / ((meanFilterIntensity * 2 + 1) * (meanFilterIntensity * 2 + 1))); // R
-    
-                    Vec3b* output_row = image_output.ptr<Vec3b>(j);
-    
-                    // Aplica o filtro de nitidez com intensidade k em cada canal, evitando overflow com a função clamp
-                    output_row[i][0] = clamp( (double) round(this->image.ptr<Vec3b>(j)[i][0] + k * gMask[0]), 0.0, 255.0); // B
-                    output_row[i][1] = clamp( (double) round(this->image.ptr<Vec3b>(j)[i][1] + k * gMask[1]), 0.0, 255.0); // G
-                    output_row[i][2] = clamp( (double) round(this->image.ptr<Vec3b>(j)[i][2] + k * gMask[2]), 0.0, 255.0); // R
-                }
-            }
-    
-        } else // Se a imagem for HSV, aplica o filtro no canal de Valor
-        if (this->color_type == ImageColorType::HSV) {
-    
-            // Para cada pixel da imagem, aplica o filtro
-            for (int i = region.x_begin; i <= region.x_end; i++) {
-                for (int j = region.y_begin; j <= region.y_end; j++) {
-                    int meanValue = 0;
-    
-                    // Para cada pixel vizinho, soma os valores dos pixels vizinhos no canal de Valor
-                    for (int k = -meanFilterIntensity; k <= meanFilterIntensity; k++) {
-                        for (int l = -meanFilterIntensity; l <= meanFilterIntensity; l++) {
-                            // Pega o pixel vizinho
-                            int x = i + k;
-                            int y = j + l;
-    
-                            // Ignora pixels fora da imagem (mesma coisa que somar com 0, ou seja, usar o zero-padding)
-                            if (x < 0 || x >= this->width || y < 0 || y >= this->height) {
-                                continue;
-                            }
-    
-                            const Vec3b* input_row = this->image.ptr<Vec3b>(y); // Usando ptr<> para acessar a linha de pixels
-                            meanValue += input_row[x][2]; // V
-                        }
-                    }
-    
-                    // Calcula a mascara de nitidez no pixel atual para o canal de Valor
-                    float gMask = 0;
-                    gMask = (this->image.ptr<Vec3b>(j)[i][2]) - (meanValue / ((meanFilterIntensity * 2 + 1) * (meanFilterIntensity * 2 + 1))); // V
-    
-                    Vec3b* output_row = image_output.ptr<Vec3b>(j);
-    
-                    output_row[i][0] = this->image.ptr<Vec3b>(j)[i][0]; // H (mantém o mesmo valor)
-                    output_row[i][1] = this->image.ptr<Vec3b>(j)[i][1]; // S (mantém o mesmo valor)
-
-                    // Aplica o filtro de nitidez com intensidade k no canal de Valor, evitando overflow com a função clamp
-                    output_row[i][2] = clamp((double) round(this->image.ptr<Vec3b>(j)[i][2] + k * gMask), 0.0, 255.0); // V
-                }
-            }
-            // ------------------- fim do else if HSV
-    
-        } else { // Se a imagem for em tons de cinza, aplica no canal único
-    
-            // Para cada pixel da imagem, aplica o filtro
-            for (int i = region.x_begin; i <= region.x_end; i++) {
-                for (int j = region.y_begin; j <= region.y_end; j++) {
-                    int meanValue = 0;
-    
-                    // Para cada pixel vizinho, soma os valores dos pixels vizinhos em cada canal
-                    for (int k = -meanFilterIntensity; k <= meanFilterIntensity; k++) {
-                        for (int l = -meanFilterIntensity; l <= meanFilterIntensity; l++) {
-                            // Pega o pixel vizinho
-                            int x = i + k;
-                            int y = j + l;
-    
-                            // Ignora pixels fora da imagem (mesma coisa que somar com 0, ou seja, usar o zero-padding)
-                            if (x < 0 || x >= this->width || y < 0 || y >= this->height) {
-                                continue;
-                            }
-    
-                            const uchar* input_row = this->image.ptr<uchar>(y); // Usando ptr<> para acessar a linha de pixels
-                            meanValue += input_row[x]; // Canal único
-                        }
-                    }
-    
-                    // Calcula a mascara de nitidez no pixel atual para o canal único
-                    float gMask = 0;
-                    gMask = (this->image.ptr<uchar>(j)[i]) - (meanValue / ((meanFilterIntensity * 2 + 1) * (meanFilterIntensity * 2 + 1))); 
-    
-                    uchar* output_row = image_output.ptr<uchar>(j);
-    
-                    // Aplica o filtro de nitidez com intensidade k no canal único, evitando overflow com a função clamp
-                    output_row[i] = clamp((double) round(this->image.ptr<uchar>(j)[i] + k * gMask), 0.0, 255.0);
-                }
-            }
-            // ------------------- fim do else GRAYSCALE
-        }
-    }    
-
-
-void Image::
-    median_filter(Region region, Mat& image_output, int intensity) {
-
-        // Se a imagem for BGR, aplica o filtro em cada canal
-        if(this->color_type == ImageColorType::RGB){
-
-            // Aplica o filtro de mediana em cada canal
-            for (int i = region.x_begin; i <= region.x_end; i++) {
-                for (int j = region.y_begin; j <= region.y_end; j++) {
-                    vector<uchar> pixels[3]; // Vetor para armazenar os pixels vizinhos de cada canal
-    
-                    // Para cada pixel vizinho, pega os valores dos pixels vizinhos em cada canal
-                    for (int k = -intensity; k <= intensity; k++) {
-                        for (int l = -intensity; l <= intensity; l++) {
-                            // Pega o pixel vizinho
-                            int x = i + k;
-                            int y = j + l;
-    
-                            // Ignora pixels fora da imagem (mesma coisa que somar com 0, ou seja, usar o zero-padding)
-                            if (x < 0 || x >= this->width || y < 0 || y >= this->height) {
-                                continue;
-                            }
-    
-                            const Vec3b* input_row = this->image.ptr<Vec3b>(y); // Usando ptr<> para acessar a linha de pixels
-                            pixels[0].push_back(input_row[x][0]); // B
-                            pixels[1].push_back(input_row[x][1]); // G
-                            pixels[2].push_back(input_row[x][2]); // R
-                        }
-                    }
-    
-                    Vec3b* output_row = image_output.ptr<Vec3b>(j);
-    
-                    // Ordena os valores dos pixels vizinhos e pega a mediana para cada canal
-                    for (int c = 0; c < 3; c++) {
-                        sort(pixels[c].begin(), pixels[c].end());
-                        output_row[i][c] = pixels[c][pixels[c].size() / 2];
-                    }
-                }
-            }
-
-        // Caso em que é pra imagem resultado ser HSV
-        }else 
-        if(this->color_type == ImageColorType::HSV){
-            
-            // Aplica o filtro de mediana no canal de Valor
-            for(int i = region.x_begin; i <= region.x_end; i++) {
-                for (int j = region.y_begin; j <= region.y_end; j++) {
-                    vector<uchar> pixels;
-    
-                    // Para cada pixel vizinho, pega os valores dos pixels vizinhos no canal de Valor
-                    for (int k = -intensity; k <= intensity; k++) {
-                        for (int l = -intensity; l <= intensity; l++) {
-                            // Pega o pixel vizinho
-                            int x = i + k;
-                            int y = j + l;
-    
-                            // Ignora pixels fora da imagem (mesma coisa que somar com 0, ou seja, usar o zero-padding)
-                            if (x < 0 || x >= this->width || y < 0 || y >= this->height) {
-                                continue;
-                            }
-    
-                            const Vec3b* input_row = this->image.ptr<Vec3b>(y); // Usando ptr<> para acessar a linha de pixels
-                            pixels.push_back(input_row[x][2]); // V
-                        }
-                    }
-    
-                    // Ordena os valores dos pixels vizinhos e pega a mediana
-                    sort(pixels.begin(), pixels.end());
-                    uchar medianValue = pixels[pixels.size() / 2];
-    
-                    Vec3b* output_row = image_output.ptr<Vec3b>(j);
-    
-                    output_row[i][0] = this->image.ptr<Vec3b>(j)[i][0]; // H (mantém o mesmo valor)
-                    output_row[i][1] = this->image.ptr<Vec3b>(j)[i][1]; // S (mantém o mesmo valor)
-
-                    // Define o pixel da imagem de saída como a mediana dos pixels vizinhos
-                    output_row[i][2] = medianValue;
-                }
-            }
-
-        // Caso em que é pra imagem resultado ser em tons de cinza
-        } else {
-
-            // Para cada pixel da imagem, aplica o filtro
-            for (int i = region.x_begin; i <= region.x_end; i++) {
-                for (int j = region.y_begin; j <= region.y_end; j++) {
-                    vector<uchar> pixels;
-    
-                    // Para cada pixel vizinho, pega os valores dos pixels vizinhos no canal único
-                    for (int k = -intensity; k <= intensity; k++) {
-                        for (int l = -intensity; l <= intensity; l++) {
-                            // Pega o pixel vizinho
-                            int x = i + k;
-                            int y = j + l;
-    
-                            // Ignora pixels fora da imagem (mesma coisa que somar com 0, ou seja, usar o zero-padding)
-                            if (x < 0 || x >= this->width || y < 0 || y >= this->height) {
-                                continue;
-                            }
-    
-                            const uchar* input_row = this->image.ptr<uchar>(y); // Usando ptr<> para acessar a linha de pixels
-                            pixels.push_back(input_row[x]); // Canal único
-                        }
-                    }
-    
-                    // Ordena os valores dos pixels vizinhos e pega a mediana
-                    sort(pixels.begin(), pixels.end());
-                    uchar medianValue = pixels[pixels.size() / 2];
-    
-                    uchar* output_row = image_output.ptr<uchar>(j);
-    
-                    // Define o pixel da imagem de saída como a mediana dos pixels vizinhos
-                    output_row[i] = medianValue;
-                }
-            }
-
-        }
-    }
-
 void Image::
-    grayscale_filter(Region region, Mat& image_output) {
-
-        // Se a imagem for BGR, aplica o filtro em cada canal
-        if(this->color_type == ImageColorType::RGB){
-            // O canal azul tem peso 0.114, o verde 0.587 e o vermelho 0.299
-
-            for(int i = region.x_begin; i <= region.x_end; i++){
-                for (int j = region.y_begin; j <= region.y_end; j++){
-
-                    // Pega o pixel da imagem de saída
-                    Vec3b& pixel = image_output.at<Vec3b>(j, i);
-
-                    // Aplica o filtro de grayscale em cada canal
-                    pixel[0] = round(0.114 * this->image.at<Vec3b>(j, i)[0] + 0.587 * this->image.at<Vec3b>(j, i)[1] + 0.299 * this->image.at<Vec3b>(j, i)[2]); // B
-                    pixel[1] = pixel[0]; // G
-                    pixel[2] = pixel[0]; // R
-                }
-            }
-
-
-
-        }else if(this->color_type == ImageColorType::HSV){
-            // Caso em que é pra imagem resultado ser HSV
-            // Define a saturacao como 0, pois remove qualquer perceptibilidade de cor
-            // O canal H nao precisa ser alterado, pois o valor de H eh irrelevante para a imagem em tons de cinza
-            // O canal V mantem-se o mesmo, pois a intensidade eh dada pelo canal de Valor
-
-            for(int i = region.x_begin; i <= region.x_end; i++){
-                for (int j = region.y_begin; j <= region.y_end; j++){
-
-                    // Pega o pixel da imagem de saída
-                    Vec3b& pixel = image_output.at<Vec3b>(j, i);
-
-                    // Aplica o filtro de grayscale em cada canal
-                    pixel[0] = this->image.at<Vec3b>(j, i)[0]; // H
-                    pixel[1] = 0; // S
-                    pixel[2] = this->image.at<Vec3b>(j, i)[2]; // V
-                }
-            }
-        }
-        
-    }
-    
-// Função que gera a mascara gaussiana de acordo com o tamanho do kernel passado
-vector<vector<float>> generateGaussianKernel(int kernelSize) {
-    if(kernelSize % 2 == 0) {
-        kernelSize++; // Garante que o tamanho do kernel seja ímpar
-    }
-
-    vector<vector<float>> kernel(kernelSize, vector<float>(kernelSize));
-
-    float sigma = kernelSize / 2.0f; // uma aproximação pra sigma baseada no tamanho
-    float sum = 0.0f;
-    int center = kernelSize / 2;
-
-    // Gera a máscara gaussiana
-    for (int i = 0; i < kernelSize; i++) {
-        for (int j = 0; j < kernelSize; j++) {
-            int x = i - center;
-            int y = j - center;
-            kernel[i][j] = std::exp(-(x*x + y*y) / (2.0f * sigma * sigma));
-            sum += kernel[i][j];
-        }
-    }
-
-    // Normaliza para que a soma total seja 1
-    for (int i = 0; i < kernelSize; i++) {
-        for (int j = 0; j < kernelSize; j++) {
-            kernel[i][j] /= sum;
-        }
+    lut_filter(Region region, Mat& image_output) {
+        const LutKernels& kernels = lut_kernels();
+        int cn = this->image.channels();
+        int n = region.x_end - region.x_begin + 1;
+
+        for_each_row(region, [&](int j, int x_begin, int) {
+            const uchar* input_row = this->image.ptr<uchar>(j) + x_begin * cn;
+            uchar* output_row = image_output.ptr<uchar>(j) + x_begin * cn;
+
+            // se a imagem for HSV, aplica a tabela no canal de Valor (H e S mantêm o mesmo valor)
+            if (this->color_type == ImageColorType::HSV)
+                kernels.apply_channel(this->point_lut, input_row, output_row, n, 2);
+            // se a imagem for BGR ou em tons de cinza, aplica em todos os canais (byte a byte)
+            else
+                kernels.apply(this->point_lut, input_row, output_row, n * cn);
+        });
     }
 
-    return kernel;
-}
-
 void Image::
     gaussian_filter(Region region, Mat& image_output, int intensity){
 
         Interval interval = {1, 40};
         intensity = (int) normalizeInInterval(intensity, interval); // Normaliza a intensidade para o intervalo [1, 40]
 
-        Mask_t gaussian_mask = Mask_t(generateGaussianKernel(intensity)); // gera a mascara gaussiana de acordo com a intensidade passada
-        int kernel_radius = gaussian_mask.mask_.size() / 2; // raio do kernel
-
-        // Se a imagem for BGR, aplica a mascara em cada canal
-        if(this->color_type == ImageColorType::RGB){
-
-            // pra cada pixel da imagem, aplica o filtro
-            for(int i = region.x_begin; i <= region.x_end; i++){
-                for(int j = region.y_begin; j <= region.y_end; j++){
-                    float meanValue[] = {0.0, 0.0, 0.0};
-
-                    // na vizinhanca da imagem de entrada, aplica a mascara
-                    for(int k = -kernel_radius; k <= kernel_radius; k++){
-                        for(int l = -kernel_radius; l <= kernel_radius; l++){
-                            // Pega o pixel vizinho
-                            int x = i + k;
-                            int y = j + l;
-
-                            // Ignora pixels fora da imagem (mesma coisa que somar com 0, ou seja, usar o zero-padding)
-                            if (x < 0 || x >= this->width || y < 0 || y >= this->height) {
-                                continue;
-                            }
-                            
-                            // Pega o pixel da imagem de saída
-                            Vec3b& pixel = this->image.at<Vec3b>(y, x);
-
-                            // Calcula a média ponderada dos pixels vizinhos em cada canal
-                            meanValue[0] += pixel[0] * gaussian_mask.mask_[l + kernel_radius][k + kernel_radius]; // B
-                            meanValue[1] += pixel[1] * gaussian_mask.mask_[l + kernel_radius][k + kernel_radius]; // G
-                            meanValue[2] += pixel[2] * gaussian_mask.mask_[l + kernel_radius][k + kernel_radius]; // R
-                        }
-
-                    }
-
-                    // Pega o pixel da imagem de saída
-                    Vec3b& pixel = image_output.at<Vec3b>(j, i);
-
-                    // Aplica a mascara em cada canal
-                    pixel[0] = clamp((double) round(meanValue[0]), 0.0, 255.0); // B
-                    pixel[1] = clamp((double) round(meanValue[1]), 0.0, 255.0); // G
-                    pixel[2] = clamp((double) round(meanValue[2]), 0.0, 255.0); // R
-                }
-            }
-                
-        }else // se a imagem for HSV, aplica a mascara no canal de Valor
-        if(this->color_type == ImageColorType::HSV){
-            
-            // pra cada pixel da imagem, aplica o filtro
-            for(int i = region.x_begin; i <= region.x_end; i++){
-                for(int j = region.y_begin; j <= region.y_end; j++){
-                    float meanValue = 0.0;
-
-                    // na vizinhanca da imagem de entrada, aplica a mascara
-                    for(int k = -kernel_radius; k <= kernel_radius; k++){
-                        for(int l = -kernel_radius; l <= kernel_radius; l++){
-                            // Pega o pixel vizinho
-                            int x = i + k;
-                            int y = j + l;
-
-                            // Ignora pixels fora da imagem (mesma coisa que somar com 0, ou seja, usar o zero-padding)
-                            if (x < 0 || x >= this->width || y < 0 || y >= this->height) {
-                                continue;
-                            }
-                            
-                            // Pega o pixel da imagem de saída
-                            Vec3b& pixel = this->image.at<Vec3b>(y, x);
-
-                            // Calcula a média ponderada dos pixels vizinhos no canal de Valor
-                            meanValue += pixel[2] * gaussian_mask.mask_[l + kernel_radius][k + kernel_radius]; // V
-                        }
-
-                    }
-                    // Pega o pixel da imagem de saída
-                    Vec3b& pixel = image_output.at<Vec3b>(j, i);
-
-                    pixel[0] = this->image.ptr<Vec3b>(j)[i][0]; // H (mantém o mesmo valor)
-                    pixel[1] = this->image.ptr<Vec3b>(j)[i][1]; // S (mantém o mesmo valor)
-
-                    // Aplica a mascara no canal de Valor
-                    pixel[2] = clamp((double) round(meanValue), 0.0, 255.0); // V
-                }
-            }
+        // Se a imagem for HSV, aplica a mascara apenas no canal de Valor (H e S mantêm o mesmo valor)
+        // Se for BGR ou tons de cinza, aplica em todos os canais
+        int only_channel = (this->color_type == ImageColorType::HSV) ? 2 : -1;
 
-        }else{ // imagem em tons de conza
-
-            // pra cada pixel da imagem, aplica o filtro
-            for(int i = region.x_begin; i <= region.x_end; i++){
-                for(int j = region.y_begin; j <= region.y_end; j++){
-                    float meanValue = 0.0;
-
-                    // na vizinhanca da imagem de entrada, aplica a mascara
-                    for(int k = -kernel_radius; k <= kernel_radius; k++){
-                        for(int l = -kernel_radius; l <= kernel_radius; l++){
-                            // Pega o pixel vizinho
-                            int x = i + k;
-                            int y = j + l;
-
-                            // Ignora pixels fora da imagem (mesma coisa que somar com 0, ou seja, usar o zero-padding)
-                            if (x < 0 || x >= this->width || y < 0 || y >= this->height) {
-                                continue;
-                            }
-                            
-                            // Pega o pixel da imagem de saída
-                            uchar& pixel = this->image.at<uchar>(y, x);
-
-                            // Aplica a mascara no canal de Valor
-                            meanValue += pixel * gaussian_mask.mask_[l + kernel_radius][k + kernel_radius];
-                        }
-
-                    }
-                    // Pega o pixel da imagem de saída
-                    uchar& pixel = image_output.at<uchar>(j, i);
-
-                    // Aplica a mascara no canal único
-                    pixel = clamp((double) round(meanValue), 0.0, 255.0); // R
-                }
-            }
+        // pega o kernel 1D pré-calculado para a intensidade passada, na aritmética escolhida
+        if (this->convolution_path == ConvolutionPath::FIXED) {
+            const vector<int16_t>& gaussian_kernel = GaussianKernelTable::instance().get_fixed(intensity);
+            separable_gaussian_fixed(this->image_padded, image_output, region, gaussian_kernel, only_channel);
+        } else {
+            // Kernels grandes usam a versão recursiva, que não é aplicada por região: `process` a roda na imagem inteira
+            const vector<float>& gaussian_kernel = GaussianKernelTable::instance().get(intensity);
+            separable_gaussian(this->image_padded, image_output, region, gaussian_kernel, only_channel);
         }
     }
 
-void Image::
-    apply_mask_filter(Region region, Mat& image_output, Mask_t mask_Mat, int intensity, int weight) {
-
-        Interval interval = {1.0, 2.0};
-        float k = normalizeInInterval(intensity, interval); // Normaliza a intensidade para o intervalo [1.0, 2]
-
-        int kernel_radius = mask_Mat.mask_.size() / 2; // raio do kernel
-
-        // Se a imagem for BGR, aplica a mascara em cada canal
-        if(this->color_type == ImageColorType::RGB){
-
-            // pra cada pixel da imagem, aplica o filtro
-            for(int i = region.x_begin; i <= region.x_end; i++){
-                for(int j = region.y_begin; j <= region.y_end; j++){
-                    int meanValue[] = {0, 0, 0};
-
-                    // na vizinhanca da imagem de entrada, aplica a mascara
-                    for(int k = -kernel_radius; k <= kernel_radius; k++){
-                        for(int l = -kernel_radius; l <= kernel_radius; l++){
-                            // Pega o pixel vizinho
-                            int x = i + k;
-                            int y = j + l;
-
-                            // Ignora pixels fora da imagem (mesma coisa que somar com 0, ou seja, usar o zero-padding)
-                            if (x < 0 || x >= this->width || y < 0 || y >= this->height) {
-                                continue;
-                            }
-                            
-                            // Pega o pixel da imagem de saída
-                            Vec3b& pixel = this->image.at<Vec3b>(y, x);
-
-                            // Calcula a média ponderada dos pixels vizinhos em cada canal
-                            meanValue[0] += pixel[0] * mask_Mat.mask_[l+1][k+1]; // B
-                            meanValue[1] += pixel[1] * mask_Mat.mask_[l+1][k+1]; // G
-                            meanValue[2] += pixel[2] * mask_Mat.mask_[l+1][k+1]; // R
-                        }
-
-                    }
-                    int g_mask[] = {0, 0, 0};
-                    // Calcula a mascara no pixel atual para cada canal
-                    // g_mask[0] = this->image.ptr<Vec3b>(j)[i][0] - meanValue[0]/weight; // B
-                    // g_mask[1] = this->image.ptr<Vec3b>(j)[i][1] - meanValue[1]/weight; // G
-                    // g_mask[2] = this->image.ptr<Vec3b>(j)[i][2] - meanValue[2]/weight; // R
-
-                    // Pega o pixel da imagem de saída
-                    Vec3b& pixel = image_output.at<Vec3b>(j, i);
-
-                    // Aplica a mascara em cada canal
-                    // pixel[0] = clamp((double) round(this->image.ptr<Vec3b>(j)[i][0] + k * g_mask[0]), 0.0, 255.0); // B
-                    // pixel[1] = clamp((double) round(this->image.ptr<Vec3b>(j)[i][1] + k * g_mask[1]), 0.0, 255.0); // G
-                    // pixel[2] = clamp((double) round(this->image.ptr<Vec3b>(j)[i][2] + k * g_mask[2]), 0.0, 255.0); // R
-                    pixel[0] = clamp((double) round(meanValue[0]/weight), 0.0, 255.0); // B
-                    pixel[1] = clamp((double) round(meanValue[1]/weight), 0.0, 255.0); // G
-                    pixel[2] = clamp((double) round(meanValue[2]/weight), 0.0, 255.0); // R
-                }
-            }
-                
-        }else // se a imagem for HSV, aplica a mascara no canal de Valor
-        if(this->color_type == ImageColorType::HSV){
-            
-            // pra cada pixel da imagem, aplica o filtro
-            for(int i = region.x_begin; i <= region.x_end; i++){
-                for(int j = region.y_begin; j <= region.y_end; j++){
-                    int meanValue = 0;
-
-                    // na vizinhanca da imagem de entrada, aplica a mascara
-                    for(int k = -kernel_radius; k <= kernel_radius; k++){
-                        for(int l = -kernel_radius; l <= kernel_radius; l++){
-                            // Pega o pixel vizinho
-                            int x = i + k;
-                            int y = j + l;
-
-                            // Ignora pixels fora da imagem (mesma coisa que somar com 0, ou seja, usar o zero-padding)
-                            if (x < 0 || x >= this->width || y < 0 || y >= this->height) {
-                                continue;
-                            }
-                            
-                            // Pega o pixel da imagem de saída
-                            Vec3b& pixel = this->image.at<Vec3b>(y, x);
-
-                            // Calcula a média ponderada dos pixels vizinhos no canal de Valor
-                            meanValue += pixel[2] * mask_Mat.mask_[l+1][k+1]; // V
-                        }
-
-                    }
-                    // Pega o pixel da imagem de saída
-                    Vec3b& pixel = image_output.at<Vec3b>(j, i);
-
-                    // Calcula a mascara no pixel atual para o canal de Valor
-                    // int g_mask = 0;
-                    // g_mask = this->image.ptr<Vec3b>(j)[i][2] - meanValue/weight;
-
-                    pixel[0] = this->image.ptr<Vec3b>(j)[i][0]; // H (mantém o mesmo valor)
-                    pixel[1] = this->image.ptr<Vec3b>(j)[i][1]; // S (mantém o mesmo valor)
-
-                    // Aplica a mascara no canal de Valor
-                    // pixel[2] = clamp((double) round(this->image.ptr<Vec3b>(j)[i][2] + k * g_mask), 0.0, 255.0); // V
-                    pixel[2] = clamp((double) round(meanValue/weight), 0.0, 255.0); // V
-                }
-            }
-
-        // imagem em tons de conza 
-        }else{ 
-
-            // pra cada pixel da imagem, aplica o filtro
-            for(int i = region.x_begin; i <= region.x_end; i++){
-                for(int j = region.y_begin; j <= region.y_end; j++){
-                    int meanValue = 0;
-
-                    // na vizinhanca da imagem de entrada, aplica a mascara
-                    for(int k = -kernel_radius; k <= kernel_radius; k++){
-                        for(int l = -kernel_radius; l <= kernel_radius; l++){
-                            // Pega o pixel vizinho
-                            int x = i + k;
-                            int y = j + l;
-
-                            // Ignora pixels fora da imagem (mesma coisa que somar com 0, ou seja, usar o zero-padding)
-                            if (x < 0 || x >= this->width || y < 0 || y >= this->height) {
-                                continue;
-                            }
-                            
-                            // Pega o pixel da imagem de saída
-                            uchar& pixel = this->image.at<uchar>(y, x);
-
-                            // Aplica a mascara no canal de Valor
-                            meanValue += pixel * mask_Mat.mask_[l+1][k+1];
-                        }
-
-                    }
-                    // Calcula a mascara no pixel atual para o canal único
-                    // int g_mask = 0;
-                    // g_mask = this->image.ptr<uchar>(j)[i] - meanValue/weight;
-
-                    // Pega o pixel da imagem de saída
-                    uchar& pixel = image_output.at<uchar>(j, i);
-
-                    // Aplica a mascara no canal de Valor
-                    // pixel = clamp((double) round(this->image.ptr<uchar>(j)[i] + k * g_mask), 0.0, 255.0); // V
-                    pixel = clamp((double) round(meanValue/weight), 0.0, 255.0); // V
-                }
-            }
-        }
-    }   
-
-
 void Image::
     laplacian90_border_detection_filter(Region region, Mat& image_output, int intensity){
-        Mask_t laplacian90_mask = Mask_t({  {0,  1, 0}, 
-                                            {1, -4, 1}, 
-                                            {0,  1, 0} }); // mascara de laplaciano sem as diagonais
-
-        apply_mask_filter(region, image_output, laplacian90_mask, intensity, 1); // peso dos valores da mascara = 1
+        // stencil 3x3 com a mascara de laplaciano sem as diagonais, especializado em tempo de compilação
+        bool only_v = (this->color_type == ImageColorType::HSV);
+        stencil3x3<Laplacian90Mask, StencilMode::BORDER>(this->image_padded, image_output, region, only_v);
     }
 void Image::
     laplacian45_border_detection_filter(Region region, Mat& image_output, int intensity){
-        Mask_t laplacian45_mask = Mask_t({  {1,  1, 1}, 
-                                            {1, -8, 1}, 
-                                            {1,  1, 1} }); // mascara de laplaciano com as diagonais
-
-        apply_mask_filter(region, image_output, laplacian45_mask, intensity, 1); // peso dos valores da mascara = 1
+        // stencil 3x3 com a mascara de laplaciano com as diagonais, especializado em tempo de compilação
+        bool only_v = (this->color_type == ImageColorType::HSV);
+        stencil3x3<Laplacian45Mask, StencilMode::BORDER>(this->image_padded, image_output, region, only_v);
     }
 
 void Image::
     laplacian90_sharpen_filter(Region region, Mat& image_output, int intensity){
-        Mask_t laplacian90_mask = Mask_t({  {0,  1, 0}, 
-                                            {1, -4, 1}, 
-                                            {0,  1, 0} }); // mascara de laplaciano sem as diagonais
-
         Interval interval = {0.5, 3.5};
-        float k = normalizeInInterval(intensity, interval); // Normaliza a intensidade para o intervalo [0.5, 2]
-
-        // Se a imagem for BGR, aplica a mascara em cada canal
-        if(this->color_type == ImageColorType::RGB){
-
-            // pra cada pixel da imagem, aplica o filtro
-            for(int i = region.x_begin; i <= region.x_end; i++){
-                for(int j = region.y_begin; j <= region.y_end; j++){
-                    int meanValue[] = {0, 0, 0};
-
-                    // na vizinhanca da imagem de entrada, aplica a mascara
-                    for(int k = -1; k <= 1; k++){
-                        for(int l = -1; l <= 1; l++){
-                            // Pega o pixel vizinho
-                            int x = i + k;
-                            int y = j + l;
-
-                            // Ignora pixels fora da imagem (mesma coisa que somar com 0, ou seja, usar o zero-padding)
-                            if (x < 0 || x >= this->width || y < 0 || y >= this->height) {
-                                continue;
-                            }
-                            
-                            // Pega o pixel da imagem de saída
-                            Vec3b& pixel = this->image.at<Vec3b>(y, x);
-
-                            // Calcula a média ponderada dos pixels vizinhos em cada canal
-                            meanValue[0] += pixel[0] * laplacian90_mask.mask_[l+1][k+1]; // B
-                            meanValue[1] += pixel[1] * laplacian90_mask.mask_[l+1][k+1]; // G
-                            meanValue[2] += pixel[2] * laplacian90_mask.mask_[l+1][k+1]; // R
-                        }
-
-                    }
-                    // Pega o pixel da imagem de saída
-                    Vec3b& pixel = image_output.at<Vec3b>(j, i);
-                    Vec3b& input_pixel = this->image.at<Vec3b>(j, i); 
-
-                    // Aplica a mascara em cada canal
-                    pixel[0] = clamp((double) round(input_pixel[0] - k * meanValue[0]), 0.0, 255.0); // B
-                    pixel[1] = clamp((double) round(input_pixel[1] - k * meanValue[1]), 0.0, 255.0); // G
-                    pixel[2] = clamp((double) round(input_pixel[2] - k * meanValue[2]), 0.0, 255.0); // R
-                }
-            }
-                
-        }else // se a imagem for HSV, aplica a mascara no canal de Valor
-        if(this->color_type == ImageColorType::HSV){
-            
-            // pra cada pixel da imagem, aplica o filtro
-            for(int i = region.x_begin; i <= region.x_end; i++){
-                for(int j = region.y_begin; j <= region.y_end; j++){
-                    int meanValue = 0;
-
-                    // na vizinhanca da imagem de entrada, aplica a mascara
-                    for(int k = -1; k <= 1; k++){
-                        for(int l = -1; l <= 1; l++){
-                            // Pega o pixel vizinho
-                            int x = i + k;
-                            int y = j + l;
-
-                            // Ignora pixels fora da imagem (mesma coisa que somar com 0, ou seja, usar o zero-padding)
-                            if (x < 0 || x >= this->width || y < 0 || y >= this->height) {
-                                continue;
-                            }
-                            
-                            // Pega o pixel da imagem de saída
-                            Vec3b& pixel = this->image.at<Vec3b>(y, x);
-
-
-                            // Calcula a média ponderada dos pixels vizinhos no canal de Valor
-                            meanValue += pixel[2] * laplacian90_mask.mask_[l+1][k+1]; // V
-                        }
-
-                    }
-                    // Pega o pixel da imagem de saída
-                    Vec3b& pixel = image_output.at<Vec3b>(j, i);
-                    Vec3b& input_pixel = this->image.at<Vec3b>(j, i);
-
-                    pixel[0] = input_pixel[0]; // H (mantém o mesmo valor)
-                    pixel[1] = input_pixel[1]; // S (mantém o mesmo valor)
-
-                    // Aplica a mascara no canal de Valor
-                    pixel[2] = clamp((double) round(input_pixel[2] - k * meanValue), 0.0, 255.0); // V
-                }
-            }
-
-        }else{ // imagem em tons de conza
-
-            // pra cada pixel da imagem, aplica o filtro
-            for(int i = region.x_begin; i <= region.x_end; i++){
-                for(int j = region.y_begin; j <= region.y_end; j++){
-                    int meanValue = 0;
-
-                    // na vizinhanca da imagem de entrada, aplica a mascara
-                    for(int k = -1; k <= 1; k++){
-                        for(int l = -1; l <= 1; l++){
-                            // Pega o pixel vizinho
-                            int x = i + k;
-                            int y = j + l;
-
-                            // Ignora pixels fora da imagem (mesma coisa que somar com 0, ou seja, usar o zero-padding)
-                            if (x < 0 || x >= this->width || y < 0 || y >= this->height) {
-                                continue;
-                            }
-                            
-                            // Pega o pixel da imagem de saída
-                            uchar& pixel = this->image.at<uchar>(y, x);
-                            
-                            // Aplica a mascara no canal de Valor
-                            meanValue += pixel * laplacian90_mask.mask_[l+1][k+1];
-                        }
-                        
-                    }
-                    // Pega o pixel da imagem de saída
-                    uchar& pixel = image_output.at<uchar>(j, i);
-                    uchar& input_pixel = this->image.at<uchar>(j, i);
+        float k = normalizeInInterval(intensity, interval); // Normaliza a intensidade para o intervalo [0.5, 3.5]
 
-                    // Aplica a mascara no canal de Valor
-                    pixel = clamp((double) round(input_pixel - k * meanValue), 0.0, 255.0); // R
-                }
-            }
-        }
+        // Se a imagem for HSV, aplica a mascara no canal de Valor. Senão, em todos os canais
+        bool only_v = (this->color_type == ImageColorType::HSV);
+        stencil3x3<Laplacian90Mask, StencilMode::SHARPEN>(this->image_padded, image_output, region, only_v, k);
     }   
 
 void Image::
     laplacian45_sharpen_filter(Region region, Mat& image_output, int intensity){
-        Mask_t laplacian45_mask = Mask_t({  {1,  1, 1}, 
-                                            {1, -8, 1}, 
-                                            {1,  1, 1} }); // mascara de laplaciano com as diagonais
-
         Interval interval = {0.5, 3.5};
         float k = normalizeInInterval(intensity, interval); // Normaliza a intensidade para o intervalo [0.5, 3.5]
 
-        // Se a imagem for BGR, aplica a mascara em cada canal
-        if(this->color_type == ImageColorType::RGB){
-
-            // pra cada pixel da imagem, aplica o filtro
-            for(int i = region.x_begin; i <= region.x_end; i++){
-                for(int j = region.y_begin; j <= region.y_end; j++){
-                    int meanValue[] = {0, 0, 0};
-
-                    // na vizinhanca da imagem de entrada, aplica a mascara
-                    for(int k = -1; k <= 1; k++){
-                        for(int l = -1; l <= 1; l++){
-                            // Pega o pixel vizinho
-                            int x = i + k;
-                            int y = j + l;
-
-                            // Ignora pixels fora da imagem (mesma coisa que somar com 0, ou seja, usar o zero-padding)
-                            if (x < 0 || x >= this->width || y < 0 || y >= this->height) {
-                                continue;
-                            }
-                            
-                            // Pega o pixel da imagem de saída
-                            Vec3b& pixel = this->image.at<Vec3b>(y, x);
-
-                            // Calcula a média ponderada dos pixels vizinhos em cada canal
-                            meanValue[0] += pixel[0] * laplacian45_mask.mask_[l+1][k+1]; // B
-                            meanValue[1] += pixel[1] * laplacian45_mask.mask_[l+1][k+1]; // G
-                            meanValue[2] += pixel[2] * laplacian45_mask.mask_[l+1][k+1]; // R
-                        }
-
-                    }
-                    // Pega o pixel da imagem de saída
-                    Vec3b& pixel = image_output.at<Vec3b>(j, i);
-                    Vec3b& input_pixel = this->image.at<Vec3b>(j, i); 
-
-                    // Aplica a mascara em cada canal
-                    pixel[0] = clamp((double) round(input_pixel[0] - k * meanValue[0]), 0.0, 255.0); // B
-                    pixel[1] = clamp((double) round(input_pixel[1] - k * meanValue[1]), 0.0, 255.0); // G
-                    pixel[2] = clamp((double) round(input_pixel[2] - k * meanValue[2]), 0.0, 255.0); // R
-                }
-            }
-                
-        }else // se a imagem for HSV, aplica a mascara no canal de Valor
-        if(this->color_type == ImageColorType::HSV){
-            
-            // pra cada pixel da imagem, aplica o filtro
-            for(int i = region.x_begin; i <= region.x_end; i++){
-                for(int j = region.y_begin; j <= region.y_end; j++){
-                    int meanValue = 0;
-
-                    // na vizinhanca da imagem de entrada, aplica a mascara
-                    for(int k = -1; k <= 1; k++){
-                        for(int l = -1; l <= 1; l++){
-                            // Pega o pixel vizinho
-                            int x = i + k;
-                            int y = j + l;
-
-                            // Ignora pixels fora da imagem (mesma coisa que somar com 0, ou seja, usar o zero-padding)
-                            if (x < 0 || x >= this->width || y < 0 || y >= this->height) {
-                                continue;
-                            }
-                            
-                            // Pega o pixel da imagem de saída
-                            Vec3b& pixel = this->image.at<Vec3b>(y, x);
-
-                            // Aplica a mascara no canal de Valor
-                            meanValue += pixel[2] * laplacian45_mask.mask_[l+1][k+1]; // V
-                        }
-
-                    }
-                    // Pega o pixel da imagem de saída
-                    Vec3b& pixel = image_output.at<Vec3b>(j, i);
-                    Vec3b& input_pixel = this->image.at<Vec3b>(j, i);
-
-                    pixel[0] = input_pixel[0]; // H (mantém o mesmo valor)
-                    pixel[1] = input_pixel[1]; // S (mantém o mesmo valor)
-
-                    // Aplica a mascara no canal de Valor
-                    pixel[2] = clamp((double) round(input_pixel[2] - k * meanValue), 0.0, 255.0); // V
-                }
-            }
-
-        }else{ // imagem em tons de conza
-
-            // pra cada pixel da imagem, aplica o filtro
-            for(int i = region.x_begin; i <= region.x_end; i++){
-                for(int j = region.y_begin; j <= region.y_end; j++){
-                    int meanValue = 0;
-
-                    // na vizinhanca da imagem de entrada, aplica a mascara
-                    for(int k = -1; k <= 1; k++){
-                        for(int l = -1; l <= 1; l++){
-                            // Pega o pixel vizinho
-                            int x = i + k;
-                            int y = j + l;
-
-                            // Ignora pixels fora da imagem (mesma coisa que somar com 0, ou seja, usar o zero-padding)
-                            if (x < 0 || x >= this->width || y < 0 || y >= this->height) {
-                                continue;
-                            }
-                            
-                            // Pega o pixel da imagem de saída
-                            uchar& pixel = this->image.at<uchar>(y, x);
-                            
-                            // Aplica a mascara no canal unico
-                            meanValue += pixel * laplacian45_mask.mask_[l+1][k+1];
-                        }
-                        
-                    }
-                    // Pega o pixel da imagem de saída
-                    uchar& pixel = image_output.at<uchar>(j, i);
-                    uchar& input_pixel = this->image.at<uchar>(j, i);
-
-                    // Aplica a mascara no canal único
-                    pixel = clamp((double) round(input_pixel - k * meanValue), 0.0, 255.0); 
-                }
-            }
-        }
+        // Se a imagem for HSV, aplica a mascara no canal de Valor. Senão, em todos os canais
+        bool only_v = (this->color_type == ImageColorType::HSV);
+        stencil3x3<Laplacian45Mask, StencilMode::SHARPEN>(this->image_padded, image_output, region, only_v, k);
     }   
     
 // ---
     
-// THREADS ////////////////////////
+// Retorna o raio da vizinhança que o filtro lê ao redor de cada pixel, com zero-padding
+// (a mediana não entra, pois ignora os pixels de fora da imagem ao invés de usar zeros)
+int
+    neighborhood_radius(const string& filter, int intensity){
+        if (filter == "blur")
+            return intensity;
+        if (filter == "sharpen")
+            return 5;
+        if (filter == "gaussian"){
+            Interval interval = {1, 40};
+            return GaussianKernelTable::instance().get((int) normalizeInInterval(intensity, interval)).size() / 2;
+        }
+        if (filter.rfind("laplacian", 0) == 0)
+            return 1;
+        return 0;
+    }
 
-// Reparte A em B pedacos de tamanhos aproximadamente iguais
-vector<int> 
-    getSteps(int A, int B){
-        vector<int> result(B, A/B); // inicializa o vetor com o valor base
+// Retorna os nomes de todos os filtros aceitos por `process`
+const vector<string>&
+    filter_names(){
+        static const vector<string> names = {
+            "negative",
+            "thresholding",
+            "blur",
+            "sharpen",
+            "grayscale",
+            "median",
+            "gaussian",
+            "laplacian90 sharpen",
+            "laplacian45 sharpen",
+            "laplacian90 border",
+            "laplacian45 border",
+            "gamma",
+            "contrast",
+            "posterize"
+        };
+        return names;
+    }
 
-        int excess = A % B; // resto da divisao
+// Retorna se o filtro é uma operação pontual feita por tabela de consulta
+bool
+    is_lut_filter(const string& filter){
+        return filter == "gamma" || filter == "contrast" || filter == "posterize";
+    }
 
-        for (int i = 0; i < excess; i++){
-            result[i] += 1; // distribui o resto entre as partes
+// Monta a tabela de consulta de um filtro pontual, de acordo com a intensidade
+PointLut
+    make_filter_lut(const string& filter, int intensity){
+        if (filter == "gamma"){
+            Interval interval = {0.2, 3.0};
+            return lut_gamma(normalizeInInterval(intensity, interval)); // gama no intervalo [0.2, 3.0]
         }
-
-        return result;
+        if (filter == "contrast"){
+            Interval interval = {0.5, 3.0};
+            return lut_contrast(normalizeInInterval(intensity, interval)); // fator no intervalo [0.5, 3.0]
+        }
+        if (filter == "posterize"){
+            Interval interval = {0, 30};
+            return lut_posterize(32 - (int) round(normalizeInInterval(intensity, interval))); // de 32 níveis (intensidade 1) a 2 níveis (20)
+        }
+        throw invalid_argument("Filtro inválido!");
     }
-    
-vector<Region>
-    getRegions(int width, int height, int threads) {
-        vector<Region> regions;
-        
-        if (width > height) {
-            vector<int> steps = getSteps(width, threads);
-            int last = -1;
-
-            for(int i = 0; i < threads; i++) {
-                Region region;
-                
-                // Se for o último, pega o resto da imagem
-                if (i == threads - 1) {
-                    region.x_begin = last+1;
-                    region.x_end = width-1;
-                } else {
-                    region.x_begin = last+1;
-                    last = region.x_end = last + steps[i];
-                }
-
-                region.y_begin = 0;
-                region.y_end = height-1;
-                regions.push_back(region);
-            }
 
-        } else {
-            vector<int> steps = getSteps(height, threads);
-            int last = -1;
+// THREADS ////////////////////////
 
-            if (threads > height){
-                threads = height;  // garante que o número de threads nao exceda a altura da imagem
+// Reparte a imagem em blocos (tiles) de até tile_size x tile_size pixels, em ordem de linhas
+// Muitos blocos pequenos, pegos dinamicamente pelas threads, equilibram filtros de custo irregular
+vector<Region>
+    getTiles(int width, int height, int tile_size) {
+        vector<Region> tiles;
+
+        for (int y = 0; y < height; y += tile_size) {
+            for (int x = 0; x < width; x += tile_size) {
+                Region tile;
+                tile.x_begin = x;
+                tile.x_end = min(x + tile_size, width) - 1;
+                tile.y_begin = y;
+                tile.y_end = min(y + tile_size, height) - 1;
+                tiles.push_back(tile);
             }
+        }
 
-            for(int i = 0; i < threads; i++) {
-                Region region;
-                
-                // Se for o último, pega o resto da imagem
-                if (i == threads - 1) {
-                    region.y_begin = last+1;
-                    region.y_end = height-1;
-                } else {
-                    region.y_begin = last+1;
-                    last = region.y_end = last + steps[i];
-                }
+        return tiles;
+    }
 
-                region.x_begin = 0;
-                region.x_end = width-1;
-                regions.push_back(region);
-            }
-        }
+int Image::
+    tile_halo(const string& filter) {
+        if (filter == "median")
+            return this->intensity;
+        // A versão recursiva filtra linhas e colunas inteiras: não há margem em volta dos blocos
+        if (this->recursive_gaussian_kernel(filter))
+            return 0;
+        return neighborhood_radius(filter, this->intensity);
+    }
 
-        return regions;
+const vector<float>* Image::
+    recursive_gaussian_kernel(const string& filter) {
+        if (filter != "gaussian" || this->convolution_path != ConvolutionPath::FLOAT)
+            return nullptr;
+        Interval interval = {1, 40};
+        const vector<float>& kernel = GaussianKernelTable::instance().get((int) normalizeInInterval(this->intensity, interval));
+        return ((int) kernel.size() / 2 >= RECURSIVE_GAUSSIAN_MIN_RADIUS) ? &kernel : nullptr;
     }
 
-// Essa funcao devera delegar a regiao recebida a uma funcao de filtro, utilizando o atributo filter e intensity da classe Image
+// Delega a regiao recebida a uma funcao de filtro, utilizando o atributo intensity da classe Image
 void Image::
-    thread_process(const string& filter, int threads, Region region) {
+    apply_filter(const string& filter, Region region, Mat& image_output) {
 
         if(filter == "negative")
-            this->negative_filter(region, this->image_multiThread);
+            this->negative_filter(region, image_output);
         else if(filter == "thresholding")
-            this->thresholding_filter(region, this->image_multiThread, this->intensity);
+            this->thresholding_filter(region, image_output, this->intensity);
         else if(filter == "blur")
-            this->blur_filter(region, this->image_multiThread, this->intensity);
+            this->blur_filter(region, image_output, this->intensity);
         else if(filter == "sharpen")
-            this->sharpen_filter(region, this->image_multiThread, this->intensity);
+            this->sharpen_filter(region, image_output, this->intensity);
         else if(filter == "median")
-            this->median_filter(region, this->image_multiThread, this->intensity);
+            this->median_filter(region, image_output, this->intensity);
         else if(filter == "grayscale")
-            this->grayscale_filter(region, this->image_multiThread);
+            this->grayscale_filter(region, image_output);
+        else if(is_lut_filter(filter))
+            this->lut_filter(region, image_output);
         else if(filter == "gaussian")
-            this->gaussian_filter(region, this->image_multiThread, this->intensity);
+            this->gaussian_filter(region, image_output, this->intensity);
         else if(filter == "laplacian90 border")
-            this->laplacian90_border_detection_filter(region, this->image_multiThread, this->intensity);
+            this->laplacian90_border_detection_filter(region, image_output, this->intensity);
         else if(filter == "laplacian45 border")
-            this->laplacian45_border_detection_filter(region, this->image_multiThread, this->intensity);
+            this->laplacian45_border_detection_filter(region, image_output, this->intensity);
         else if(filter == "laplacian90 sharpen")
-            this->laplacian90_sharpen_filter(region, this->image_multiThread, this->intensity);
+            this->laplacian90_sharpen_filter(region, image_output, this->intensity);
         else if(filter == "laplacian45 sharpen")
-            this->laplacian45_sharpen_filter(region, this->image_multiThread, this->intensity);
+            this->laplacian45_sharpen_filter(region, image_output, this->intensity);
         else
             throw invalid_argument("Filtro inválido!");
-        
-        this->threads_done++;
-        if (this->threads_done == threads) {
-            this->timer_multiThread.end = high_resolution_clock::now();
-            this->timer_multiThread.timer_duration = duration_cast<milliseconds>(this->timer_multiThread.end - this->timer_multiThread.start);
-            this->multi_thread_ended = true;
-            cout << "Multi-Threads terminaram o processamento! Em " << this->timer_multiThread.timer_duration.count() << " milissegundos"<< endl;
+    }
+
+void Image::
+    split_tiles_by_node() {
+        vector<int> weights = this->thread_pool->workers_per_node();
+        int nodes = weights.size();
+        int total = 0;
+        for (int weight : weights) total += weight;
+
+        int rows = (this->height + this->tile_side - 1) / this->tile_side;
+        this->node_rows.assign(nodes + 1, 0);
+        int accumulated = 0;
+        for (int k = 0; k < nodes; k++) {
+            accumulated += weights[k];
+            this->node_rows[k + 1] = total > 0 ? (int) ((long long) rows * accumulated / total) : rows;
+        }
+        this->node_rows[nodes] = rows;
+
+        this->node_next = make_unique<atomic<int>[]>(nodes);
+        for (int k = 0; k < nodes; k++) this->node_next[k] = 0;
+    }
+
+int Image::
+    claim_work(int node, int scale) {
+        int nodes = this->node_rows.size() - 1;
+        node = node % nodes;
+
+        for (int i = 0; i < nodes; i++) {
+            int k = (node + i) % nodes;
+            int begin = this->node_rows[k] * scale;
+            int end = this->node_rows[k + 1] * scale;
+            if (begin + this->node_next[k].load(memory_order_relaxed) >= end) continue;
+
+            int index = begin + this->node_next[k].fetch_add(1, memory_order_relaxed);
+            if (index < end) return index;
+        }
+        return -1;
+    }
+
+// Cada thread zera linhas de blocos livres, uma de cada vez, até acabarem
+void Image::
+    first_touch_process() {
+        int node = ThreadPool::current_node();
+
+        while (!CancellationToken::requested()) {
+            int row = this->claim_work(node, 1);
+            if (row < 0) break;
+
+            int y_begin = row * this->tile_side;
+            int y_end = min(y_begin + this->tile_side, this->height);
+            this->image_multiThread.rowRange(y_begin, y_end).setTo(Scalar::all(0));
+        }
+    }
+
+// Cada thread pega blocos livres, um de cada vez, até acabarem ou até a fatia de tempo acabar
+bool Image::
+    thread_process(const string& filter, int worker, TilePhase phase) {
+        int node = ThreadPool::current_node();
+        shared_ptr<DirtyTiles> dirty = atomic_load(&this->multi_dirty);
+        auto deadline = steady_clock::now() + microseconds(TILE_TASK_QUANTUM_US);
+        int only_channel = (this->color_type == ImageColorType::HSV) ? 2 : -1;
+
+        // Confere o cancelamento a cada bloco (e os filtros, a cada linha)
+        while (!CancellationToken::requested()) {
+            // Fatia de tempo acabou e há tarefas de outros processamentos esperando: cede a vez
+            if (steady_clock::now() >= deadline && this->thread_pool->has_waiting_tasks()) return true;
+
+            // Gaussiano recursivo, passada horizontal: uma linha de blocos inteira para o buffer
+            if (phase == TilePhase::RECURSIVE_ROWS) {
+                int row = this->claim_work(node, 1);
+                if (row < 0) break;
+
+                int y_begin = row * this->tile_side;
+                int y_end = min(y_begin + this->tile_side, this->height) - 1;
+                recursive_gaussian_rows(this->image_padded, this->recursive_rows.data(), y_begin, y_end, *this->recursive_gaussian_kernel(filter), only_channel);
+                continue;
+            }
+
+            // Gaussiano recursivo, passada vertical: uma faixa de colunas da largura dos blocos, na altura inteira
+            if (phase == TilePhase::RECURSIVE_COLUMNS) {
+                int column = this->recursive_next_column.fetch_add(1, memory_order_relaxed);
+                if (column >= this->tiles_per_row) break;
+
+                int x_begin = column * this->tile_side;
+                int x_end = min(x_begin + this->tile_side, this->width) - 1;
+                recursive_gaussian_columns(this->image_padded, this->recursive_rows.data(), this->image_multiThread, x_begin, x_end, *this->recursive_gaussian_kernel(filter), only_channel);
+
+                // Todos os blocos da faixa ficaram prontos
+                int rows = (int) this->tiles.size() / this->tiles_per_row;
+                this->tiles_per_worker[worker].fetch_add(rows, memory_order_relaxed);
+                if (!CancellationToken::requested()) {
+                    for (int row = 0; row < rows; row++) dirty->mark(row * this->tiles_per_row + column, worker);
+                }
+                continue;
+            }
+
+            int index = this->claim_work(node, this->tiles_per_row);
+            if (index < 0) break;
+
+            this->apply_filter(filter, this->tiles[index], this->image_multiThread);
+            this->tiles_per_worker[worker].fetch_add(1, memory_order_relaxed);
+
+            // Bloco inteiro escrito: passa a ser enviado nas consultas de progresso
+            if (!CancellationToken::requested()) dirty->mark(index, worker);
+        }
+        return false;
+    }
+
+void Image::
+    run_tile_task(const string& filter, int worker, shared_ptr<WaitGroup> group, shared_ptr<CancellationToken> token, TilePhase phase) {
+        bool yielded;
+        {
+            CancellationScope scope(token.get());
+            yielded = this->thread_process(filter, worker, phase);
+        }
+
+        if (yielded) {
+            this->thread_pool->submit([this, filter, worker, group, token, phase] {
+                this->run_tile_task(filter, worker, group, token, phase);
+            }, this->priority, true);
+        } else {
+            group->done();
         }
     }
 
 void Image::
     single_thread_process(const string& filter, Region region) {
+        shared_ptr<DirtyTiles> dirty = atomic_load(&this->single_dirty);
 
-        if(filter == "negative")
-            this->negative_filter(region, this->image_singleThread);
-        else if(filter == "thresholding")
-            this->thresholding_filter(region, this->image_singleThread, this->intensity);
-        else if(filter == "blur")
-            this->blur_filter(region, this->image_singleThread, this->intensity);
-        else if(filter == "sharpen")
-            this->sharpen_filter(region, this->image_singleThread, this->intensity);
-        else if(filter == "median")
-            this->median_filter(region, this->image_singleThread, this->intensity);
-        else if(filter == "grayscale")
-            this->grayscale_filter(region, this->image_singleThread);
-        else if(filter == "gaussian")
-            this->gaussian_filter(region, this->image_singleThread, this->intensity);
-        else if(filter == "laplacian90 border")
-            this->laplacian90_border_detection_filter(region, this->image_singleThread, this->intensity);
-        else if(filter == "laplacian45 border")
-            this->laplacian45_border_detection_filter(region, this->image_singleThread, this->intensity);
-        else if(filter == "laplacian90 sharpen")
-            this->laplacian90_sharpen_filter(region, this->image_singleThread, this->intensity);
-        else if(filter == "laplacian45 sharpen")
-            this->laplacian45_sharpen_filter(region, this->image_singleThread, this->intensity);
-        else
-            throw invalid_argument("Filtro inválido!");
+        // Gaussiano recursivo: as duas passadas na imagem inteira (a mesma conta da versão em multi-thread, linha a linha e coluna a coluna)
+        if (const vector<float>* kernel = this->recursive_gaussian_kernel(filter)) {
+            int only_channel = (this->color_type == ImageColorType::HSV) ? 2 : -1;
+            int nc = (only_channel < 0) ? this->image_padded.cn : 1;
+            vector<float> rows((size_t) this->height * this->width * nc);
 
-         // Salva a imagem processada
-         // Coleta o vector de pixels da imagem e transforma em imagem
+            recursive_gaussian_rows(this->image_padded, rows.data(), 0, this->height - 1, *kernel, only_channel);
+            if (CancellationToken::requested()) return;
+            recursive_gaussian_columns(this->image_padded, rows.data(), this->image_singleThread, 0, this->width - 1, *kernel, only_channel);
+
+            for (int i = 0; i < dirty->size() && !CancellationToken::requested(); i++) dirty->mark(i, 0);
+            return;
+        }
 
-        this->timer_singleThread.end = high_resolution_clock::now();
-        this->timer_singleThread.timer_duration = duration_cast<milliseconds>(this->timer_singleThread.end - this->timer_singleThread.start);
-        this->single_thread_ended = true;
-        cout << "Single-Thread terminou o processamento!" << " Em " << this->timer_singleThread.timer_duration.count() << " milissegundos"<< endl;
+        // Processa a região em faixas horizontais, de cima para baixo, marcando cada faixa concluída para as consultas de progresso
+        for (int i = 0; i < dirty->size() && !CancellationToken::requested(); i++) {
+            Region band = dirty->tile(i);
+            band.x_begin = max(band.x_begin, region.x_begin);
+            band.x_end = min(band.x_end, region.x_end);
+            band.y_begin = max(band.y_begin, region.y_begin);
+            band.y_end = min(band.y_end, region.y_end);
+            if (band.x_begin > band.x_end || band.y_begin > band.y_end) continue;
+
+            this->apply_filter(filter, band, this->image_singleThread);
+            if (!CancellationToken::requested()) dirty->mark(i, 0);
+        }
     }
 
 
 void Image::
-    process(const string& filter, int threads, int intensity = 1) {
+    process(const string& filter, int threads, int intensity = 1, ConvolutionPath path = ConvolutionPath::FLOAT) {
+        // Recusa filtros desconhecidos antes de criar qualquer tarefa
+        if (find(filter_names().begin(), filter_names().end(), filter) == filter_names().end()) {
+            throw invalid_argument("Filtro inválido!");
+        }
+        // A intensidade define o raio da vizinhança, e portanto o tamanho da borda e das somas: recusa valores fora do intervalo
+        if (intensity < MIN_FILTER_INTENSITY || intensity > MAX_FILTER_INTENSITY) {
+            throw invalid_argument("Intensidade inválida!");
+        }
+
+        // Cancela o processamento anterior, se ainda estiver rodando, e espera as tarefas dele pararem:
+        // elas escrevem nas imagens de saída, que são realocadas abaixo
+        this->cancel_processing();
+
+        // Novo número de processamento: tarefas de processamentos anteriores não marcam este como concluído
+        int job = ++this->job_id;
+        auto token = make_shared<CancellationToken>();
+        atomic_store(&this->cancel_token, token);
+
         // Define, inicialmente, que o processamento em multi-thread e em single-thread ainda não acabou, ou seja, que ainda ainda estão em processamento.
         this->single_thread_ended = false;
         this->multi_thread_ended = false;
+        this->speedup = -1;
+        this->parallel_efficiency = -1;
+        atomic_store(&this->single_encoded, shared_ptr<const EncodedImage>());
+        atomic_store(&this->multi_encoded, shared_ptr<const EncodedImage>());
 
-        // Deve guardar no objeto o atributo intensity
+        // Deve guardar no objeto o atributo intensity e a aritmética das convoluções
         this->intensity = intensity;
+        this->convolution_path = path;
+
+        // Filtros pontuais por tabela: monta a tabela uma única vez, antes de repartir a imagem
+        if (is_lut_filter(filter)) {
+            this->point_lut = make_filter_lut(filter, intensity);
+        }
 
-        // Limpa as imagens de saída, colocando todos os pixels como 0 (preto)
-        // Para que no front a visualização do processamento seja melhor, mudando os pixels a medida que eles são processados
+        // Se o filtro pedir uma vizinhança maior que a borda de zeros atual, remonta a borda com o tamanho necessário
+        int radius = neighborhood_radius(filter, intensity);
+        if (radius > this->image_padded.padding) {
+            this->image_padded.build(this->image, radius);
+        }
+
+        // Aloca as imagens de saída sem preenchê-las: cada uma é zerada (todos os pixels 0, preto) pelas threads que vão escrever nela,
+        // para que as páginas de memória fiquem no nó NUMA dessas threads (primeiro toque)
+        // Zeradas, a visualização do processamento no front é melhor, mudando os pixels a medida que eles são processados
             switch(this->color_type){
                 // Se a imagem for colorida, cria uma imagem de 3 canais
                 case ImageColorType::RGB:
                 case ImageColorType::HSV:
-                    this->image_singleThread = Mat(this->height, this->width, CV_8UC3, Scalar(0, 0, 0));
-                    this->image_multiThread = Mat(this->height, this->width, CV_8UC3, Scalar(0, 0, 0));
+                    this->image_singleThread = Mat(this->height, this->width, CV_8UC3);
+                    this->image_multiThread = Mat(this->height, this->width, CV_8UC3);
                     break;
                 case ImageColorType::GRAYSCALE:
-                    this->image_singleThread = Mat(this->height, this->width, CV_8UC1, Scalar(0));
-                    this->image_multiThread = Mat(this->height, this->width, CV_8UC1, Scalar(0));
+                    this->image_singleThread = Mat(this->height, this->width, CV_8UC1);
+                    this->image_multiThread = Mat(this->height, this->width, CV_8UC1);
                     break;
                 default:
                     break;
@@ -1799,31 +1609,210 @@ void Image::
             * Inicia o timer para o processamento em single-thread
             * Cria uma região que representa a imagem inteira (x: 0 a width-1, y: 0 a height-1)
             * Envia a região para o processamento em single-thread
-            * Quando o processamento acabar, o timer é parado e a variável single_thread_ended é setada como true
+            * Quando o processamento acabar, o grupo de espera para o timer e seta a variável single_thread_ended como true
         */
-        this->timer_singleThread.start = high_resolution_clock::now();
-        this->thread_pool->enqueue([this, filter, threads] {
+        auto single_group = make_shared<WaitGroup>(1);
+        single_group->then([this, job, token] {
+            if (job != this->job_id || token->is_cancelled()) return;
+            this->timer_singleThread.end = high_resolution_clock::now();
+            this->timer_singleThread.timer_duration = duration_cast<milliseconds>(this->timer_singleThread.end - this->timer_singleThread.start);
+
+            // Codifica a saída uma única vez, antes de marcá-la como concluída: as consultas seguintes só copiam os bytes
+            atomic_store(&this->single_encoded, this->make_encoded(this->image_singleThread));
+            this->single_thread_ended = true;
+            this->progress_signal->notify();
+            cout << "Single-Thread terminou o processamento!" << " Em " << this->timer_singleThread.timer_duration.count() << " milissegundos"<< endl;
+        });
+        atomic_store(&this->single_thread_group, single_group);
+
+        auto run_single = [this, filter, single_group, token] {
+            CancellationScope scope(token.get());
             Region region = {0, this->width-1, 0, this->height-1}; // A imagem inteira
+            this->image_singleThread.setTo(Scalar::all(0));
             this->single_thread_process(filter, region);
-        });
+            single_group->done();
+        };
     
         // 2. MULTI-THREADING:
-        // Primeiramente, reparte a imagem em partes quase iguais, de acordo com o número de threads
+        // Primeiramente, reparte a imagem em blocos. Filtros com vizinhança grande usam blocos maiores,
+        // para que as margens recalculadas por cada bloco não dominem o trabalho
         cout << endl << "Iniciando processamento em " << threads << " threads..." << endl;
-        vector<Region> regions = getRegions(this->width, this->height, threads);
+        this->tile_side = max(this->tile_size, 4 * this->tile_halo(filter));
+        this->tiles = getTiles(this->width, this->height, this->tile_side);
+        this->tiles_per_row = (this->width + this->tile_side - 1) / this->tile_side;
+
+        // Acompanhamento do progresso: os blocos de cada saída, marcados conforme são concluídos
+        vector<Region> bands;
+        for (int y = 0; y < this->height; y += this->tile_side) {
+            bands.push_back({0, this->width - 1, y, min(y + this->tile_side, this->height) - 1});
+        }
+        atomic_store(&this->single_dirty, make_shared<DirtyTiles>(bands, this->progress_signal));
+        atomic_store(&this->multi_dirty, make_shared<DirtyTiles>(this->tiles, this->progress_signal));
 
-        // Em seguida, reseta o contador de threads e o timer
-        this->threads_done = 0;                                                            
-        this->timer_multiThread.start = high_resolution_clock::now();
-        
-        // Atribui a cada thread uma parte da imagem para processar
-        for (int i = 0; i < threads; i++){
-            this->thread_pool->enqueue([this, filter, threads,  regions, i] {
-                this->thread_process(filter, threads, regions[i]);
+        // Não adianta ter mais threads que blocos
+        threads = max(1, min(threads, (int) this->tiles.size()));
+
+        // Gaussiano recursivo: buffer da passada horizontal, lido pela vertical depois que todas as linhas terminarem
+        const vector<float>* recursive_kernel = this->recursive_gaussian_kernel(filter);
+        if (recursive_kernel) {
+            int nc = (this->color_type == ImageColorType::HSV) ? 1 : this->image_padded.cn;
+            this->recursive_rows.resize((size_t) this->height * this->width * nc);
+        } else {
+            vector<float>().swap(this->recursive_rows);
+        }
+
+        // Se forem pedidas mais threads do que o pool tem, ele cresce. Nunca encolhe aqui: o pool pode estar sendo usado
+        // por outros processamentos (quem o compartilha, como o JobManager, decide quando voltar ao tamanho normal)
+        if (threads > this->thread_pool->size()) {
+            this->thread_pool->resize(threads);
+        }
+
+        // Em seguida, divide as linhas de blocos entre os nós NUMA e reseta os contadores de blocos e o timer
+        this->split_tiles_by_node();
+        this->tiles_per_worker.reset(new atomic<int>[threads]);
+        for (int i = 0; i < threads; i++) this->tiles_per_worker[i].store(0, memory_order_relaxed);
+        this->tiles_per_worker_count = threads;
+
+        // Quando todas as threads terminarem, o grupo de espera para o timer e seta a variável multi_thread_ended como true
+        auto multi_group = make_shared<WaitGroup>(threads);
+        bool benchmark = this->benchmark_mode;
+        multi_group->then([this, job, token, threads, benchmark] {
+            if (job != this->job_id || token->is_cancelled()) return;
+            this->timer_multiThread.end = high_resolution_clock::now();
+            this->timer_multiThread.timer_duration = duration_cast<milliseconds>(this->timer_multiThread.end - this->timer_multiThread.start);
+
+            // No modo benchmark, a versão single-thread já terminou (rodou antes): calcula o speedup e a eficiência paralela
+            if (benchmark && this->single_thread_ended) {
+                double single_ms = duration<double, milli>(this->timer_singleThread.end - this->timer_singleThread.start).count();
+                double multi_ms = duration<double, milli>(this->timer_multiThread.end - this->timer_multiThread.start).count();
+                this->speedup = single_ms / max(multi_ms, 1e-3);
+                this->parallel_efficiency = this->speedup / threads;
+                cout << "Benchmark: single " << single_ms << " ms, multi " << multi_ms << " ms em " << threads << " threads, speedup "
+                     << this->speedup << ", eficiência " << this->parallel_efficiency << endl;
+            }
+            atomic_store(&this->multi_encoded, this->make_encoded(this->image_multiThread));
+            this->multi_thread_ended = true;
+            this->progress_signal->notify();
+            cout << "Multi-Threads terminaram o processamento! Em " << this->timer_multiThread.timer_duration.count() << " milissegundos"<< endl;
+
+            // Mostra quantos blocos cada thread processou, para conferir o balanceamento
+            cout << "Blocos por thread:";
+            for (int count : this->get_tiles_per_worker()) cout << " " << count;
+            cout << " (" << this->tiles.size() << " blocos)" << endl;
+        });
+        atomic_store(&this->multi_thread_group, multi_group);
+
+        // Primeiro, as threads zeram a saída, cada uma na faixa do seu nó
+        // Quando todas terminarem, os contadores são zerados e cada thread pega blocos até não sobrar nenhum
+        // (as tarefas de blocos herdam a prioridade da tarefa que as cria)
+        // No gaussiano recursivo, as threads pegam linhas de blocos (passada horizontal) e, depois que todas terminarem,
+        // faixas de colunas (passada vertical): a barreira entre as fases garante que as colunas leem linhas já filtradas
+        // Se o processamento foi cancelado nesse meio tempo, não cria as tarefas de filtro e já libera o grupo
+        auto touch_group = make_shared<WaitGroup>(threads);
+        touch_group->then([this, filter, threads, multi_group, token, recursive_kernel] {
+            if (token->is_cancelled()) {
+                for (int i = 0; i < threads; i++) multi_group->done();
+                return;
+            }
+
+            for (int k = 0; k + 1 < (int) this->node_rows.size(); k++) this->node_next[k] = 0;
+
+            if (!recursive_kernel) {
+                for (int i = 0; i < threads; i++){
+                    this->thread_pool->submit([this, filter, i, multi_group, token] {
+                        this->run_tile_task(filter, i, multi_group, token, TilePhase::TILES);
+                    });
+                }
+                return;
+            }
+
+            auto rows_group = make_shared<WaitGroup>(threads);
+            rows_group->then([this, filter, threads, multi_group, token] {
+                if (token->is_cancelled()) {
+                    for (int i = 0; i < threads; i++) multi_group->done();
+                    return;
+                }
+
+                this->recursive_next_column = 0;
+                for (int i = 0; i < threads; i++){
+                    this->thread_pool->submit([this, filter, i, multi_group, token] {
+                        this->run_tile_task(filter, i, multi_group, token, TilePhase::RECURSIVE_COLUMNS);
+                    });
+                }
             });
+            for (int i = 0; i < threads; i++){
+                this->thread_pool->submit([this, filter, i, rows_group, token] {
+                    this->run_tile_task(filter, i, rows_group, token, TilePhase::RECURSIVE_ROWS);
+                });
+            }
+        });
+
+        auto start_multi = [this, threads, touch_group, token] {
+            this->timer_multiThread.start = high_resolution_clock::now();
+            for (int i = 0; i < threads; i++){
+                this->thread_pool->enqueue([this, touch_group, token] {
+                    CancellationScope scope(token.get());
+                    this->first_touch_process();
+                    touch_group->done();
+                }, this->priority);
+            }
+        };
+
+        // 3. INÍCIO:
+        // No modo benchmark, uma thread própria roda as duas versões, uma depois da outra; senão, as duas dividem o pool ao mesmo tempo
+        if (this->benchmark_mode) {
+            this->timer_singleThread.start = this->timer_multiThread.start = high_resolution_clock::now();
+            lock_guard<mutex> lock(this->benchmark_mtx);
+            this->benchmark_thread = thread(&Image::run_benchmark, this, run_single, start_multi, token);
+        } else {
+            this->timer_singleThread.start = high_resolution_clock::now();
+            this->thread_pool->enqueue(run_single, this->priority);
+            start_multi();
+        }
+    }
+
+void Image::
+    run_benchmark(function<void()> run_single, function<void()> start_multi, shared_ptr<CancellationToken> token) {
+        // Fixa a thread no primeiro núcleo da ordem de uso do pool, que fica livre enquanto a versão single-thread roda
+        vector<int> cpus = CpuTopology::instance().placement();
+        if (!cpus.empty()) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpus[0], &set);
+            pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
         }
+        CancellationScope scope(token.get());
 
-        // Quando todas as threads terminarem, o timer é parado e a variável multi_thread_ended é setada como true
+        // Espera as tarefas de outros processamentos terminarem, para medir com o pool ocioso
+        auto quiesce_deadline = steady_clock::now() + milliseconds(BENCHMARK_QUIESCE_TIMEOUT_MS);
+        while (!token->is_cancelled() && !this->thread_pool->is_idle() && steady_clock::now() < quiesce_deadline) {
+            this_thread::sleep_for(milliseconds(1));
+        }
+        if (!this->thread_pool->is_idle()) {
+            cout << "Benchmark: o pool não ficou ocioso, medindo mesmo assim" << endl;
+        }
+
+        // Versão single-thread, nesta thread
+        if (this->benchmark_flush) flush_caches();
+        this->timer_singleThread.start = high_resolution_clock::now();
+        run_single();
+
+        // Versão multi-thread, no pool (se o processamento foi cancelado, as tarefas só liberam o grupo)
+        if (this->benchmark_flush) flush_caches();
+        start_multi();
+    }
+
+void Image::
+    flush_caches() {
+        size_t size = 2 * last_level_cache_bytes();
+        if (size == 0) size = BENCHMARK_FLUSH_FALLBACK_BYTES;
+
+        // Escreve e lê uma linha de cache por vez; o volatile impede que o compilador descarte as leituras
+        unique_ptr<uchar[]> buffer(new uchar[size]);
+        volatile uchar sink = 0;
+        // Para no meio se o processamento da thread atual for cancelado (o buffer pode ter centenas de MB)
+        for (size_t i = 0; i < size && !CancellationToken::requested(); i += 64) buffer[i] = (uchar) i;
+        for (size_t i = 0; i < size && !CancellationToken::requested(); i += 64) sink = sink + buffer[i];
     }
 
 
@@ -1844,6 +1833,19 @@ inline ImageColorType stringToImageColorType(const string& str) {
     if (str == "gray_scale") return ImageColorType::GRAYSCALE;
     throw invalid_argument("Tipo de cor inválido");
 }
+// Recebe uma string e retorna a aritmética de convolução correspondente
+inline ConvolutionPath stringToConvolutionPath(const string& str) {
+    if (str == "float") return ConvolutionPath::FLOAT;
+    if (str == "fixed") return ConvolutionPath::FIXED;
+    throw invalid_argument("Aritmética de convolução inválida");
+}
+// Recebe uma string e retorna a classe de prioridade correspondente
+inline TaskPriority stringToTaskPriority(const string& str) {
+    if (str == "interactive") return TaskPriority::INTERACTIVE;
+    if (str == "normal") return TaskPriority::NORMAL;
+    if (str == "batch") return TaskPriority::BATCH;
+    throw invalid_argument("Prioridade inválida");
+}
 
 string Image::
     get_image_type(){
@@ -1866,7 +1868,146 @@ bool Image::
     get_single_thread_done(){
         return this->single_thread_ended;
     }
+
+bool Image::
+    wait_single_thread(int timeout_ms){
+        shared_ptr<WaitGroup> group = atomic_load(&this->single_thread_group);
+        if (group) group->wait_for(milliseconds(timeout_ms));
+        return this->single_thread_ended;
+    }
+
+bool Image::
+    wait_multi_thread(int timeout_ms){
+        shared_ptr<WaitGroup> group = atomic_load(&this->multi_thread_group);
+        if (group) group->wait_for(milliseconds(timeout_ms));
+        return this->multi_thread_ended;
+    }
     
+void Image::
+    cancel_processing(){
+        shared_ptr<CancellationToken> token = atomic_load(&this->cancel_token);
+        shared_ptr<WaitGroup> single_group = atomic_load(&this->single_thread_group);
+        shared_ptr<WaitGroup> multi_group = atomic_load(&this->multi_thread_group);
+        if (!token) return;
+
+        // Se o processamento já terminou, não há nada a cancelar
+        bool running = (single_group && !single_group->is_done()) || (multi_group && !multi_group->is_done());
+        if (running) {
+            token->cancel();
+            this->progress_signal->notify();
+            if (single_group) single_group->wait();
+            if (multi_group) multi_group->wait();
+            token->mark_stopped();
+
+            this->cancel_latency = token->latency_ms();
+            cout << "Processamento anterior cancelado! Tarefas pararam em " << this->cancel_latency << " milissegundos" << endl;
+        }
+
+        // A thread do modo benchmark termina logo depois de iniciar o processamento multi-thread
+        lock_guard<mutex> lock(this->benchmark_mtx);
+        if (this->benchmark_thread.joinable()) this->benchmark_thread.join();
+    }
+
+double Image::
+    get_cancel_latency(){
+        return this->cancel_latency;
+    }
+
+void Image::
+    set_tile_size(int size){
+        this->tile_size = max(size, 8);
+    }
+
+void Image::
+    set_priority(TaskPriority priority){
+        this->priority = priority;
+    }
+
+void Image::
+    set_benchmark(bool enabled, bool flush_caches){
+        this->benchmark_mode = enabled;
+        this->benchmark_flush = flush_caches;
+    }
+
+double Image::
+    get_speedup(){
+        return this->speedup;
+    }
+
+double Image::
+    get_parallel_efficiency(){
+        return this->parallel_efficiency;
+    }
+
+vector<int> Image::
+    get_tiles_per_worker(){
+        vector<int> counts(this->tiles_per_worker_count);
+        for (int i = 0; i < this->tiles_per_worker_count; i++) counts[i] = this->tiles_per_worker[i].load(memory_order_relaxed);
+        return counts;
+    }
+
+vector<TileUpdate> Image::
+    get_tile_updates(bool multi, uint64_t since, uint64_t& sequence){
+        vector<TileUpdate> updates;
+        sequence = since;
+        shared_ptr<DirtyTiles> dirty = atomic_load(multi ? &this->multi_dirty : &this->single_dirty);
+        if (!dirty) return updates;
+
+        // Os blocos são codificados em PNG (sem perdas, para não aparecerem emendas entre eles), só a região do bloco
+        const Mat& output = multi ? this->image_multiThread : this->image_singleThread;
+        auto encode = [&](const Region& region) {
+            Rect rect(region.x_begin, region.y_begin, region.x_end - region.x_begin + 1, region.y_end - region.y_begin + 1);
+            Mat tile = output(rect).clone();
+            if (this->color_type == ImageColorType::HSV) {
+                cvtColor(tile, tile, COLOR_HSV2BGR);
+            }
+            vector<uchar> buf;
+            imencode(".png", tile, buf);
+            return buf;
+        };
+
+        for (int index : dirty->changed_since(since, sequence)) {
+            updates.push_back({dirty->tile(index), dirty->encoded_tile(index, encode)});
+        }
+        return updates;
+    }
+
+vector<TileCompletion> Image::
+    get_tile_completions(bool multi, uint64_t since, uint64_t& sequence, int& total){
+        vector<TileCompletion> completions;
+        sequence = since;
+        total = 0;
+        shared_ptr<DirtyTiles> dirty = atomic_load(multi ? &this->multi_dirty : &this->single_dirty);
+        if (!dirty) return completions;
+
+        total = dirty->size();
+        for (int index : dirty->changed_since(since, sequence)) {
+            completions.push_back({dirty->tile(index), dirty->worker(index)});
+        }
+        return completions;
+    }
+
+shared_ptr<ProgressSignal> Image::
+    get_progress_signal(){
+        return this->progress_signal;
+    }
+
+bool Image::
+    is_cancelled(){
+        shared_ptr<CancellationToken> token = atomic_load(&this->cancel_token);
+        return token && token->is_cancelled();
+    }
+
+int Image::
+    get_width(){
+        return this->width;
+    }
+
+int Image::
+    get_height(){
+        return this->height;
+    }
+
 double Image::
     get_multi_thread_duration(bool done){
         if (done)
@@ -1886,35 +2027,44 @@ double Image::
 
 
 vector<uchar> Image::
-    get_single_thread_image(){
+    encode_output(const Mat& output){
         // Cria a imagem Mat a partir do vetor de pixels
-        Mat image_output = this->image_singleThread.clone(); // Clona a imagem de saída para evitar modificações na original
+        Mat image_output = output.clone(); // Clona a imagem de saída para evitar modificações na original
 
         // Se estiver no formato HSV, converte para BGR
         if (this->color_type == ImageColorType::HSV) {
             cvtColor(image_output, image_output, COLOR_HSV2BGR);
         }
 
-        // Cria um vetor de bytes para armazenar a imagem em formato JPEG
+        // Cria um vetor de bytes para armazenar a imagem no formato da imagem de entrada
         vector<uchar> buf;
-        imencode("." + this->get_image_type(), image_output, buf); // Codifica a imagem em JPEG
-
+        imencode("." + this->get_image_type(), image_output, buf);
         return buf;
     }
 
-vector<uchar> Image::
-    get_multi_thread_image(){
-        Mat image_output = this->image_multiThread.clone(); // Cria a imagem Mat a partir do vetor de pixels
+shared_ptr<const EncodedImage> Image::
+    make_encoded(const Mat& output){
+        auto encoded = make_shared<EncodedImage>();
+        encoded->bytes = this->encode_output(output);
+        encoded->etag = "\"" + hash_hex(content_hash(encoded->bytes.data(), encoded->bytes.size())) + "\"";
+        return encoded;
+    }
 
-        // Se estiver no formato HSV, converte para BGR
-        if (this->color_type == ImageColorType::HSV) {
-            cvtColor(image_output, image_output, COLOR_HSV2BGR);
-        }
+shared_ptr<const EncodedImage> Image::
+    get_encoded_result(bool multi){
+        return atomic_load(multi ? &this->multi_encoded : &this->single_encoded);
+    }
 
-        // Cria um vetor de bytes para armazenar a imagem em formato JPEG
-        vector<uchar> buf;
-        imencode("." + this->get_image_type(), image_output, buf); // Codifica a imagem em JPEG
-        return buf;
+vector<uchar> Image::
+    get_single_thread_image(){
+        if (shared_ptr<const EncodedImage> encoded = this->get_encoded_result(false)) return encoded->bytes;
+        return this->encode_output(this->image_singleThread);
+    }
+
+vector<uchar> Image::
+    get_multi_thread_image(){
+        if (shared_ptr<const EncodedImage> encoded = this->get_encoded_result(true)) return encoded->bytes;
+        return this->encode_output(this->image_multiThread);
     }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,231 @@
+#ifndef _IMAGE_CACHE_HPP_
+#define _IMAGE_CACHE_HPP_
+
+#include <list>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <climits>
+#include <stdexcept>
+#include <unordered_map>
+#include <opencv2/opencv.hpp>
+#include "content_hash.hpp"
+#include "image.hpp"
+
+using namespace std;
+using namespace cv;
+
+// Memória máxima, em bytes, ocupada pelas imagens decodificadas guardadas (somando as variantes de cor)
+#define IMAGE_CACHE_MAX_BYTES ((size_t) 512 << 20)
+
+/*
+    * Imagem enviada uma vez, já decodificada (BGR), e as variantes de cor usadas pelos processamentos.
+    * Cada variante (HSV, tons de cinza) é convertida uma única vez, no primeiro pedido, e compartilhada por todos os jobs:
+    * as matrizes são só lidas, nunca alteradas.
+*/
+class DecodedImage {
+    private:
+        Mat bgr;
+        Mat hsv;
+        Mat gray;
+        once_flag hsv_once;
+        once_flag gray_once;
+
+        // Memória ocupada pelas matrizes já criadas, em bytes
+        atomic<size_t> used;
+
+        static size_t bytes_of(const Mat& mat) {
+            return mat.total() * mat.elemSize();
+        }
+
+    public:
+        /*
+            * Construtor da classe DecodedImage.
+            * @param bgr Imagem decodificada com IMREAD_COLOR
+        */
+        explicit DecodedImage(const Mat& bgr) : bgr(bgr), used(bytes_of(bgr)) {}
+
+        /*
+            * Retorna a imagem no tipo de cor pedido, convertendo-a na primeira chamada para esse tipo.
+            * @param color_type Tipo de cor pedido
+            * @returns: imagem no tipo de cor pedido (compartilhada, sem cópia)
+        */
+        Mat variant(ImageColorType color_type) {
+            switch (color_type) {
+                case ImageColorType::RGB:
+                    return this->bgr;
+                case ImageColorType::HSV:
+                    call_once(this->hsv_once, [&] {
+                        cvtColor(this->bgr, this->hsv, COLOR_BGR2HSV);
+                        this->used += bytes_of(this->hsv);
+                    });
+                    return this->hsv;
+                case ImageColorType::GRAYSCALE:
+                    call_once(this->gray_once, [&] {
+                        cvtColor(this->bgr, this->gray, COLOR_BGR2GRAY);
+                        this->used += bytes_of(this->gray);
+                    });
+                    return this->gray;
+                default:
+                    throw invalid_argument("Erro: tipo de cor inválido!");
+            }
+        }
+
+        // Memória ocupada pela imagem e pelas variantes já convertidas, em bytes
+        size_t bytes() const {
+            return this->used;
+        }
+
+        int get_width() const {
+            return this->bgr.cols;
+        }
+
+        int get_height() const {
+            return this->bgr.rows;
+        }
+};
+
+/*
+    * Classe ImageCache
+    *
+    * Guarda as imagens enviadas ao servidor já decodificadas, identificadas pelo resumo SHA-256 do conteúdo (handle).
+    * O resumo é criptográfico: ninguém consegue montar um envio com o handle da imagem de outro usuário e recebê-la.
+    * Quem testa vários filtros na mesma imagem a envia uma única vez: os processamentos seguintes usam o handle,
+    * sem transferir nem decodificar a imagem de novo (e sem converter o tipo de cor, se a variante já existir).
+    *
+    * A memória é limitada a `max_bytes`: ao passar do limite, descarta as imagens usadas há mais tempo (LRU).
+    * A imagem usada por último nunca é descartada, mesmo que sozinha passe do limite.
+    * Os jobs que já usam uma imagem descartada continuam com ela: as matrizes só são liberadas quando ninguém mais as usa.
+*/
+class ImageCache {
+    private:
+        typedef struct Entry {
+            shared_ptr<DecodedImage> image;
+            list<string>::iterator position;
+            size_t bytes;
+        } Entry;
+
+        size_t max_bytes;
+        size_t used = 0;
+
+        // Handles da imagem usada por último até a usada há mais tempo
+        list<string> order;
+        unordered_map<string, Entry> entries;
+
+        // Protege os campos acima (a decodificação e a conversão de cor ficam fora do lock)
+        mutex mtx;
+
+        // Marca uma entrada como usada por último. Deve ser chamada com `mtx` travado.
+        void touch_locked(Entry& entry) {
+            this->order.splice(this->order.begin(), this->order, entry.position);
+        }
+
+        // Descarta as imagens usadas há mais tempo até caber no limite. Deve ser chamada com `mtx` travado.
+        void evict_locked() {
+            while (this->used > this->max_bytes && this->order.size() > 1) {
+                auto victim = this->entries.find(this->order.back());
+                this->used -= victim->second.bytes;
+                this->entries.erase(victim);
+                this->order.pop_back();
+            }
+        }
+
+    public:
+        /*
+            * Construtor da classe ImageCache.
+            * @param max_bytes Memória máxima ocupada pelas imagens guardadas, em bytes
+        */
+        explicit ImageCache(size_t max_bytes = IMAGE_CACHE_MAX_BYTES) : max_bytes(max_bytes) {}
+
+        /*
+            * Guarda uma imagem enviada, decodificando-a, e retorna o handle dela.
+            * Se uma imagem com o mesmo conteúdo já estiver guardada, só a marca como usada, sem decodificar de novo.
+            * @param data Início dos bytes da imagem codificada (PNG, JPEG, etc.)
+            * @param size Quantidade de bytes
+            * @returns: handle da imagem (resumo SHA-256 do conteúdo, em hexadecimal)
+        */
+        string put(const uchar* data, size_t size) {
+            if (data == nullptr || size == 0) {
+                throw invalid_argument("Erro: buffer de imagem vazio!");
+            }
+            if (size > (size_t) INT_MAX) {
+                throw invalid_argument("Erro: imagem grande demais!");
+            }
+
+            string handle = sha256_hex(data, size);
+            {
+                lock_guard<mutex> lock(this->mtx);
+                auto it = this->entries.find(handle);
+                if (it != this->entries.end()) {
+                    this->touch_locked(it->second);
+                    return handle;
+                }
+            }
+
+            // Decodifica fora do lock, direto dos bytes recebidos
+            const Mat encoded(1, (int) size, CV_8UC1, const_cast<uchar*>(data));
+            Mat bgr = imdecode(encoded, IMREAD_COLOR);
+            if (bgr.empty()) {
+                throw invalid_argument("Erro: falha ao decodificar imagem!");
+            }
+            auto image = make_shared<DecodedImage>(bgr);
+
+            lock_guard<mutex> lock(this->mtx);
+            auto it = this->entries.find(handle);
+            if (it != this->entries.end()) {
+                // Outro envio da mesma imagem chegou antes
+                this->touch_locked(it->second);
+                return handle;
+            }
+            this->order.push_front(handle);
+            this->entries[handle] = Entry{image, this->order.begin(), image->bytes()};
+            this->used += image->bytes();
+            this->evict_locked();
+            return handle;
+        }
+
+        /*
+            * Retorna uma imagem guardada, no tipo de cor pedido, e a marca como usada.
+            * @param handle Handle retornado por `put`
+            * @param color_type Tipo de cor pedido
+            * @returns: imagem no tipo de cor pedido, ou uma matriz vazia se o handle não existir (ou já tiver sido descartado)
+        */
+        Mat get(const string& handle, ImageColorType color_type) {
+            shared_ptr<DecodedImage> image;
+            {
+                lock_guard<mutex> lock(this->mtx);
+                auto it = this->entries.find(handle);
+                if (it == this->entries.end()) return Mat();
+                this->touch_locked(it->second);
+                image = it->second.image;
+            }
+
+            // A conversão de cor, na primeira vez, fica fora do lock
+            Mat converted = image->variant(color_type);
+
+            // A variante nova passa a contar no limite de memória
+            lock_guard<mutex> lock(this->mtx);
+            auto it = this->entries.find(handle);
+            if (it != this->entries.end() && it->second.image == image && it->second.bytes != image->bytes()) {
+                this->used += image->bytes() - it->second.bytes;
+                it->second.bytes = image->bytes();
+                this->evict_locked();
+            }
+            return converted;
+        }
+
+        // Memória ocupada pelas imagens guardadas, em bytes
+        size_t get_used_bytes() {
+            lock_guard<mutex> lock(this->mtx);
+            return this->used;
+        }
+
+        // Quantidade de imagens guardadas
+        size_t size() {
+            lock_guard<mutex> lock(this->mtx);
+            return this->entries.size();
+        }
+};
+
+#endif // _IMAGE_CACHE_HPP_
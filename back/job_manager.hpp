@@ -0,0 +1,273 @@
+#ifndef _JOB_MANAGER_HPP_
+#define _JOB_MANAGER_HPP_
+
+#include <map>
+#include <mutex>
+#include <deque>
+#include <memory>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include "image.hpp"
+#include "content_hash.hpp"
+
+using namespace std;
+using namespace std::chrono;
+
+// Quantidade máxima de processamentos (jobs) guardados; os mais antigos já concluídos são descartados primeiro
+#define JOB_MANAGER_MAX_JOBS 16
+
+// Tempo, em milissegundos, que um job concluído fica guardado esperando quem o criou buscar as duas saídas
+// (depois disso ele pode ser descartado mesmo sem ter sido buscado)
+#define JOB_MANAGER_GRACE_MS 60000
+
+/*
+    * Parâmetros de um processamento pedido ao servidor.
+    * `data` e `size` apontam para os bytes da imagem codificada, sem cópia (ex.: no corpo da requisição);
+    * eles só precisam existir durante `JobManager::create`, que decodifica a imagem antes de retornar.
+    * Se `decoded` não estiver vazia (imagem enviada antes, guardada no `ImageCache`), ela é usada no lugar dos bytes,
+    * já no tipo de cor `color_type`, sem decodificar de novo.
+*/
+typedef struct JobRequest {
+    const uchar* data;
+    size_t size;
+    Mat decoded;
+    ImageColorType color_type;
+    ImageType type;
+    string filter;
+    int threads;
+    int intensity;
+    ConvolutionPath path;
+    int tile_size;
+    TaskPriority priority;
+    bool benchmark;
+    bool flush_caches;
+} JobRequest;
+
+/*
+    * Job criado por `JobManager::create`: o número do job e um token secreto, que só quem criou o job conhece.
+    * Os números são sequenciais, então o token é exigido junto com o número tanto para consultar o job quanto para cancelá-lo
+    * (substituí-lo por outro).
+*/
+typedef struct JobTicket {
+    int id;
+    string token;
+} JobTicket;
+
+/*
+    * Classe JobManager
+    *
+    * Gerencia os processamentos (jobs) do servidor. Cada pedido cria um job isolado, com a sua própria `Image`
+    * (entrada, saídas e timers), identificado por um número. Todos os jobs usam o mesmo pool de threads:
+    * as tarefas de blocos de cada job cedem a vez às dos outros a cada fatia de tempo, então os jobs dividem as threads.
+    *
+    * Guarda no máximo JOB_MANAGER_MAX_JOBS jobs. Para abrir espaço, descarta o job mais antigo que já pode sair:
+    * cancelado, ou concluído com as duas saídas já buscadas (ou há mais de JOB_MANAGER_GRACE_MS).
+    * Jobs rodando nunca são cancelados para dar lugar a outro: se nenhum puder sair, o novo job é recusado.
+    *
+    * O tamanho do pool é decidido aqui, não por job: uma thread por CPU disponível, ou a maior quantidade de threads
+    * pedida por um job ainda rodando, se for maior. Assim um job que pede poucas threads não encolhe o pool de outro.
+*/
+class JobManager {
+    private:
+        // Pool de threads compartilhado por todos os jobs
+        shared_ptr<ThreadPool> thread_pool;
+
+        // Job guardado: a imagem, o token de quem o criou, a quantidade de threads pedida,
+        // se cada saída final (single, multi) já foi buscada e quando o job foi visto concluído pela primeira vez
+        typedef struct Job {
+            shared_ptr<Image> image;
+            string token;
+            int threads;
+            bool served[2] = {false, false};
+            bool finished_seen = false;
+            steady_clock::time_point finished_at;
+        } Job;
+
+        // Jobs guardados, pelo número, e a ordem de criação (para descartar os mais antigos)
+        map<int, Job> jobs;
+        deque<int> order;
+        int next_id = 1;
+
+        // Vagas reservadas por jobs sendo criados (a imagem é decodificada fora do lock), contadas no limite
+        int reserved = 0;
+
+        // Gerador dos tokens dos jobs
+        mt19937_64 token_generator{random_device{}()};
+
+        // Latência do último cancelamento de um job, em milissegundos (-1 se nenhum)
+        double last_cancel_latency = -1;
+
+        // Protege os campos acima (os jobs em si são usados fora do lock)
+        mutex mtx;
+
+        // Um job terminou as duas saídas (ou foi cancelado)?
+        static bool finished(const shared_ptr<Image>& job) {
+            return job->is_cancelled() || (job->get_single_thread_done() && job->get_multi_thread_done());
+        }
+
+        // O job pode ser descartado? Cancelado, ou concluído e já buscado (ou há mais de JOB_MANAGER_GRACE_MS). Deve ser chamada com `mtx` travado.
+        static bool evictable_locked(Job& job, steady_clock::time_point now) {
+            if (job.image->is_cancelled()) return true;
+            if (!finished(job.image)) return false;
+            if (job.served[0] && job.served[1]) return true;
+
+            // O fim do job é anotado na primeira vez em que é visto
+            if (!job.finished_seen) {
+                job.finished_seen = true;
+                job.finished_at = now;
+            }
+            return now - job.finished_at >= milliseconds(JOB_MANAGER_GRACE_MS);
+        }
+
+        /*
+            * Descarta jobs até sobrar espaço para mais um, contando as vagas reservadas. Deve ser chamada com `mtx` travado.
+            * @param evicted Recebe os jobs descartados, para serem destruídos fora do lock
+            * @returns: true se sobrou espaço, false se todos os jobs guardados ainda precisam ficar
+        */
+        bool evict_locked(vector<shared_ptr<Image>>& evicted) {
+            auto now = steady_clock::now();
+
+            while ((int) jobs.size() + reserved >= JOB_MANAGER_MAX_JOBS) {
+                // O job mais antigo que pode sair
+                auto victim = find_if(order.begin(), order.end(), [&](int id) {
+                    return evictable_locked(jobs[id], now);
+                });
+                if (victim == order.end()) return false;
+
+                evicted.push_back(jobs[*victim].image);
+                jobs.erase(*victim);
+                order.erase(victim);
+            }
+            return true;
+        }
+
+        /*
+            * Tamanho do pool para os jobs ainda rodando e um novo job. Deve ser chamada com `mtx` travado.
+            * @param threads Quantidade de threads pedida pelo novo job
+            * @returns: uma thread por CPU disponível, ou a maior quantidade de threads pedida, se for maior
+        */
+        int pool_size_locked(int threads) {
+            int size = max(effective_cpu_count(), threads);
+            for (auto& [id, job] : jobs) {
+                if (!finished(job.image)) size = max(size, job.threads);
+            }
+            return size;
+        }
+
+        // Novo token aleatório (128 bits, em hexadecimal). Deve ser chamada com `mtx` travado.
+        string new_token_locked() {
+            return hash_hex(token_generator()) + hash_hex(token_generator());
+        }
+
+    public:
+        /*
+            * Construtor da classe JobManager.
+            * @param thread_pool Pool de threads compartilhado pelos jobs
+        */
+        explicit JobManager(shared_ptr<ThreadPool> thread_pool) : thread_pool(thread_pool) {}
+
+        /*
+            * Cria um job e inicia o processamento dele.
+            * @param request Parâmetros do processamento
+            * @param replaces Número de um job anterior do mesmo usuário, que é cancelado (0 para nenhum)
+            * @param replaces_token Token do job anterior, retornado quando ele foi criado; sem o token certo, ele não é cancelado
+            * @returns: número e token do novo job, ou número 0 (e token vazio) se não houver vaga: todos os jobs guardados
+            *           estão rodando ou esperando que as saídas sejam buscadas
+        */
+        JobTicket create(const JobRequest& request, int replaces = 0, const string& replaces_token = "") {
+            // Cancela o job substituído, se foi criado por quem está pedindo: as threads ficam livres para o novo
+            shared_ptr<Image> previous;
+            int pool_size;
+            {
+                lock_guard<mutex> lock(mtx);
+                auto it = jobs.find(replaces);
+                if (it != jobs.end() && !replaces_token.empty() && it->second.token == replaces_token) previous = it->second.image;
+            }
+            if (previous) {
+                previous->cancel_processing();
+                if (previous->get_cancel_latency() >= 0) {
+                    lock_guard<mutex> lock(mtx);
+                    last_cancel_latency = previous->get_cancel_latency();
+                }
+            }
+
+            // Reserva a vaga do novo job antes de começar, descartando jobs que já podem sair; sem vaga, recusa o job
+            // Ajusta o pool aos jobs ainda rodando e ao novo, antes de o novo começar (ele não muda o tamanho do pool)
+            vector<shared_ptr<Image>> evicted;
+            {
+                lock_guard<mutex> lock(mtx);
+                if (!evict_locked(evicted)) return JobTicket{0, ""};
+                reserved++;
+                pool_size = pool_size_locked(request.threads);
+            }
+            // Os jobs descartados são destruídos aqui, fora do lock (a destruição cancela e espera as tarefas deles)
+            evicted.clear();
+            if (pool_size != thread_pool->size()) thread_pool->resize(pool_size);
+
+            // Decodifica a imagem (se ainda não estiver decodificada) e inicia o processamento fora do lock
+            shared_ptr<Image> job;
+            try {
+                job = request.decoded.empty()
+                    ? make_shared<Image>(request.data, request.size, request.color_type, request.type, thread_pool)
+                    : make_shared<Image>(request.decoded, request.color_type, request.type, thread_pool);
+                job->set_tile_size(request.tile_size);
+                job->set_priority(request.priority);
+                job->set_benchmark(request.benchmark, request.flush_caches);
+                job->process(request.filter, request.threads, request.intensity, request.path);
+            } catch (...) {
+                lock_guard<mutex> lock(mtx);
+                reserved--;
+                throw;
+            }
+
+            JobTicket ticket;
+            lock_guard<mutex> lock(mtx);
+            reserved--;
+            ticket.id = next_id++;
+            ticket.token = new_token_locked();
+            jobs[ticket.id] = Job{job, ticket.token, request.threads};
+            order.push_back(ticket.id);
+            return ticket;
+        }
+
+        /*
+            * Retorna o job com o número dado, se o token for o dele.
+            * @param id Número do job
+            * @param token Token do job, retornado quando ele foi criado
+            * @returns: o job, ou nullptr se ele não existir (ou já tiver sido descartado) ou se o token não for o dele
+        */
+        shared_ptr<Image> get(int id, const string& token) {
+            lock_guard<mutex> lock(mtx);
+            auto it = jobs.find(id);
+            if (it == jobs.end() || token.empty() || it->second.token != token) return nullptr;
+            return it->second.image;
+        }
+
+        /*
+            * Anota que a saída final de um job foi buscada: com as duas buscadas, o job pode ser descartado para dar lugar a outro.
+            * @param id Número do job
+            * @param multi true para a saída multi-thread, false para a single-thread
+            * @returns: void
+        */
+        void mark_served(int id, bool multi) {
+            lock_guard<mutex> lock(mtx);
+            auto it = jobs.find(id);
+            if (it != jobs.end()) it->second.served[multi ? 1 : 0] = true;
+        }
+
+        // Latência do último cancelamento de um job substituído, em milissegundos (-1 se nenhum)
+        double get_last_cancel_latency() {
+            lock_guard<mutex> lock(mtx);
+            return last_cancel_latency;
+        }
+
+        // Pool de threads compartilhado
+        shared_ptr<ThreadPool> get_thread_pool() {
+            return thread_pool;
+        }
+};
+
+#endif // _JOB_MANAGER_HPP_
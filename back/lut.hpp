@@ -0,0 +1,225 @@
+#ifndef _LUT_HPP_
+#define _LUT_HPP_
+
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <opencv2/opencv.hpp>
+#include "simd.hpp"
+
+using namespace std;
+using namespace cv;
+
+/*
+    * Motor de tabelas de consulta (LUT) para as operações pontuais que dependem da intensidade (gama, contraste, posterização).
+    *
+    * A tabela de 256 entradas é montada uma única vez por chamada de `process`, a partir do filtro e da intensidade,
+    * e depois aplicada byte a byte. Assim o custo por pixel não depende da conta feita pela operação (pow, divisões...).
+    *
+    * As versões SSSE3 e AVX2 fazem a consulta com pshufb, sem gather: a tabela é quebrada em 16 blocos de 16 entradas,
+    * e cada byte soma (via xor) os blocos a partir do seu. Para isso, o bloco k guarda T_k xor T_(k+1)
+    * (o último bloco de cada metade guarda o próprio T_k), de forma que a soma telescópica resulta no bloco do byte.
+*/
+
+// Tabela de consulta de 256 entradas, com os blocos usados pelas versões vetorizadas
+struct PointLut {
+    uint8_t table[256];
+
+    // deltas[k]: bloco k da tabela, em xor com o bloco k + 1 (exceto nos blocos 7 e 15)
+    uint8_t deltas[16][16];
+};
+
+/*
+    * Monta a tabela de consulta aplicando a função em todos os valores de 0 a 255.
+    * @param fn Função que recebe o valor de entrada (int) e retorna o valor de saída (uchar)
+    * @returns: tabela de consulta
+*/
+template <typename Fn>
+inline PointLut make_point_lut(Fn fn) {
+    PointLut lut;
+    for (int v = 0; v < 256; v++) lut.table[v] = fn(v);
+
+    for (int k = 0; k < 16; k++) {
+        for (int j = 0; j < 16; j++) {
+            bool last_of_half = (k == 7 || k == 15);
+            lut.deltas[k][j] = last_of_half ? lut.table[16 * k + j] : lut.table[16 * k + j] ^ lut.table[16 * (k + 1) + j];
+        }
+    }
+    return lut;
+}
+
+// Correção gama: saída = 255 * (entrada / 255) ^ gamma
+inline PointLut lut_gamma(float gamma) {
+    return make_point_lut([gamma](int v) {
+        return (uchar) std::clamp(std::round(255.0f * std::pow(v / 255.0f, gamma)), 0.0f, 255.0f);
+    });
+}
+
+// Contraste: afasta (fator > 1) ou aproxima (fator < 1) os valores do meio da escala (128)
+inline PointLut lut_contrast(float factor) {
+    return make_point_lut([factor](int v) {
+        return (uchar) std::clamp(std::round((v - 128) * factor + 128.0f), 0.0f, 255.0f);
+    });
+}
+
+// Posterização: reduz cada canal a `levels` níveis igualmente espaçados entre 0 e 255
+inline PointLut lut_posterize(int levels) {
+    levels = max(levels, 2);
+    return make_point_lut([levels](int v) {
+        int level = (int) std::round(v * (levels - 1) / 255.0f);
+        return (uchar) std::round(level * 255.0f / (levels - 1));
+    });
+}
+
+// VERSÕES ESCALARES //////////////////////////////////
+
+// Aplica a tabela em `n` bytes contínuos
+inline void apply_lut_scalar(const PointLut& lut, const uchar* src, uchar* dst, int n) {
+    const uint8_t* table = lut.table;
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        uchar a = table[src[i]], b = table[src[i + 1]], c = table[src[i + 2]], d = table[src[i + 3]];
+        dst[i] = a; dst[i + 1] = b; dst[i + 2] = c; dst[i + 3] = d;
+    }
+    for (; i < n; i++) dst[i] = table[src[i]];
+}
+
+// Aplica a tabela apenas no canal `channel` de `n` pixels BGR/HSV e copia os demais canais
+inline void apply_lut_channel_scalar(const PointLut& lut, const uchar* src, uchar* dst, int n, int channel) {
+    for (int i = 0; i < n; i++, src += 3, dst += 3) {
+        dst[0] = src[0];
+        dst[1] = src[1];
+        dst[2] = src[2];
+        dst[channel] = lut.table[src[channel]];
+    }
+}
+
+#ifdef SIMD_X86
+
+// VERSÕES SSSE3 //////////////////////////////////
+
+// Consulta 16 bytes de uma vez
+__attribute__((target("ssse3")))
+inline __m128i lut_lookup_ssse3(const PointLut& lut, __m128i x) {
+    __m128i low_half = x;                                         // bytes >= 128 ficam com o bit 7 ligado em todas as consultas
+    __m128i high_half = _mm_xor_si128(x, _mm_set1_epi8((char) 0x80)); // idem para os bytes < 128
+    __m128i result = _mm_setzero_si128();
+
+    for (int k = 0; k < 8; k++) {
+        // byte + 0x70 - 16k tem o bit 7 ligado (pshufb zera) se o byte estiver depois do bloco k
+        __m128i offset = _mm_set1_epi8((char) (0x70 - 16 * k));
+        __m128i low = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) lut.deltas[k]), _mm_adds_epu8(low_half, offset));
+        __m128i high = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) lut.deltas[k + 8]), _mm_adds_epu8(high_half, offset));
+        result = _mm_xor_si128(result, _mm_xor_si128(low, high));
+    }
+    return result;
+}
+
+__attribute__((target("ssse3")))
+inline void apply_lut_ssse3(const PointLut& lut, const uchar* src, uchar* dst, int n) {
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*) (src + i));
+        _mm_storeu_si128((__m128i*) (dst + i), lut_lookup_ssse3(lut, x));
+    }
+    apply_lut_scalar(lut, src + i, dst + i, n - i);
+}
+
+__attribute__((target("ssse3")))
+inline void apply_lut_channel_ssse3(const PointLut& lut, const uchar* src, uchar* dst, int n, int channel) {
+    const ShuffleMasks3& m = ShuffleMasks3::instance();
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        for (int v = 0; v < 3; v++) {
+            __m128i x = _mm_loadu_si128((const __m128i*) (src + 3 * i + 16 * v));
+            __m128i mask = _mm_loadu_si128((const __m128i*) m.channel16[channel][v]);
+            __m128i result = _mm_or_si128(_mm_and_si128(mask, lut_lookup_ssse3(lut, x)), _mm_andnot_si128(mask, x));
+            _mm_storeu_si128((__m128i*) (dst + 3 * i + 16 * v), result);
+        }
+    }
+    apply_lut_channel_scalar(lut, src + 3 * i, dst + 3 * i, n - i, channel);
+}
+
+// VERSÕES AVX2 //////////////////////////////////
+
+// Consulta 32 bytes de uma vez (cada bloco da tabela é repetido nas duas metades do registrador)
+__attribute__((target("avx2")))
+inline __m256i lut_lookup_avx2(const PointLut& lut, __m256i x) {
+    __m256i low_half = x;
+    __m256i high_half = _mm256_xor_si256(x, _mm256_set1_epi8((char) 0x80));
+    __m256i result = _mm256_setzero_si256();
+
+    for (int k = 0; k < 8; k++) {
+        __m256i offset = _mm256_set1_epi8((char) (0x70 - 16 * k));
+        __m256i low_table = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*) lut.deltas[k]));
+        __m256i high_table = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*) lut.deltas[k + 8]));
+        __m256i low = _mm256_shuffle_epi8(low_table, _mm256_adds_epu8(low_half, offset));
+        __m256i high = _mm256_shuffle_epi8(high_table, _mm256_adds_epu8(high_half, offset));
+        result = _mm256_xor_si256(result, _mm256_xor_si256(low, high));
+    }
+    return result;
+}
+
+__attribute__((target("avx2")))
+inline void apply_lut_avx2(const PointLut& lut, const uchar* src, uchar* dst, int n) {
+    int i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i*) (src + i));
+        _mm256_storeu_si256((__m256i*) (dst + i), lut_lookup_avx2(lut, x));
+    }
+    apply_lut_scalar(lut, src + i, dst + i, n - i);
+}
+
+__attribute__((target("avx2")))
+inline void apply_lut_channel_avx2(const PointLut& lut, const uchar* src, uchar* dst, int n, int channel) {
+    const ShuffleMasks3& m = ShuffleMasks3::instance();
+    int i = 0;
+    for (; i + 32 <= n; i += 32) {
+        for (int v = 0; v < 3; v++) {
+            __m256i x = _mm256_loadu_si256((const __m256i*) (src + 3 * i + 32 * v));
+            __m256i mask = _mm256_loadu_si256((const __m256i*) m.channel32[channel][v]);
+            __m256i result = _mm256_blendv_epi8(x, lut_lookup_avx2(lut, x), mask);
+            _mm256_storeu_si256((__m256i*) (dst + 3 * i + 32 * v), result);
+        }
+    }
+    apply_lut_channel_scalar(lut, src + 3 * i, dst + 3 * i, n - i, channel);
+}
+
+#endif // SIMD_X86
+
+// DESPACHO //////////////////////////////////
+
+/*
+    * Tabela com as funções de aplicação de LUT escolhidas para a CPU atual.
+    * `apply` recebe a quantidade de bytes; `apply_channel` recebe a quantidade de pixels de 3 canais.
+*/
+struct LutKernels {
+    SimdLevel level;
+    void (*apply)(const PointLut&, const uchar*, uchar*, int);
+    void (*apply_channel)(const PointLut&, const uchar*, uchar*, int, int);
+};
+
+/*
+    * Monta a tabela de funções de LUT de um nível de SIMD.
+    * @param level Nível de SIMD desejado
+    * @returns: tabela de funções
+*/
+inline LutKernels make_lut_kernels(SimdLevel level) {
+    LutKernels k = {SimdLevel::SCALAR, apply_lut_scalar, apply_lut_channel_scalar};
+#ifdef SIMD_X86
+    if (level == SimdLevel::SSSE3) k = {SimdLevel::SSSE3, apply_lut_ssse3, apply_lut_channel_ssse3};
+    if (level == SimdLevel::AVX2) k = {SimdLevel::AVX2, apply_lut_avx2, apply_lut_channel_avx2};
+#endif
+    return k;
+}
+
+/*
+    * Retorna as funções de LUT da CPU atual, detectadas uma única vez (na primeira chamada, feita pelo construtor de `Image`).
+    * @returns: referência para a tabela de funções
+*/
+inline const LutKernels& lut_kernels() {
+    static const LutKernels kernels = make_lut_kernels(detect_simd_level());
+    return kernels;
+}
+
+#endif // _LUT_HPP_
@@ -0,0 +1,273 @@
+#ifndef _MEDIAN_HPP_
+#define _MEDIAN_HPP_
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <opencv2/opencv.hpp>
+#include "region.hpp"
+#include "traversal.hpp"
+
+using namespace std;
+using namespace cv;
+
+// Troca a e b de lugar caso estejam fora de ordem (a fica com o menor valor e b com o maior)
+#define MEDIAN_SORT(a, b) { uchar _lo = min((a), (b)); (b) = max((a), (b)); (a) = _lo; }
+
+/*
+    * Rede de ordenação fixa que retorna a mediana de 9 valores (janela 3x3).
+    * Usa apenas comparações min/max, sem desvios, e altera a ordem do vetor recebido.
+    * @param p Vetor com 9 valores
+    * @returns: mediana dos valores
+*/
+inline uchar median_network9(uchar* p) {
+    MEDIAN_SORT(p[1], p[2]); MEDIAN_SORT(p[4], p[5]); MEDIAN_SORT(p[7], p[8]);
+    MEDIAN_SORT(p[0], p[1]); MEDIAN_SORT(p[3], p[4]); MEDIAN_SORT(p[6], p[7]);
+    MEDIAN_SORT(p[1], p[2]); MEDIAN_SORT(p[4], p[5]); MEDIAN_SORT(p[7], p[8]);
+    MEDIAN_SORT(p[0], p[3]); MEDIAN_SORT(p[5], p[8]); MEDIAN_SORT(p[4], p[7]);
+    MEDIAN_SORT(p[3], p[6]); MEDIAN_SORT(p[1], p[4]); MEDIAN_SORT(p[2], p[5]);
+    MEDIAN_SORT(p[4], p[7]); MEDIAN_SORT(p[4], p[2]); MEDIAN_SORT(p[6], p[4]);
+    MEDIAN_SORT(p[4], p[2]);
+    return p[4];
+}
+
+/*
+    * Rede de ordenação fixa que retorna a mediana de 25 valores (janela 5x5).
+    * Usa apenas comparações min/max, sem desvios, e altera a ordem do vetor recebido.
+    * @param p Vetor com 25 valores
+    * @returns: mediana dos valores
+*/
+inline uchar median_network25(uchar* p) {
+    MEDIAN_SORT(p[0], p[1]);   MEDIAN_SORT(p[3], p[4]);   MEDIAN_SORT(p[2], p[4]);
+    MEDIAN_SORT(p[2], p[3]);   MEDIAN_SORT(p[6], p[7]);   MEDIAN_SORT(p[5], p[7]);
+    MEDIAN_SORT(p[5], p[6]);   MEDIAN_SORT(p[9], p[10]);  MEDIAN_SORT(p[8], p[10]);
+    MEDIAN_SORT(p[8], p[9]);   MEDIAN_SORT(p[12], p[13]); MEDIAN_SORT(p[11], p[13]);
+    MEDIAN_SORT(p[11], p[12]); MEDIAN_SORT(p[15], p[16]); MEDIAN_SORT(p[14], p[16]);
+    MEDIAN_SORT(p[14], p[15]); MEDIAN_SORT(p[18], p[19]); MEDIAN_SORT(p[17], p[19]);
+    MEDIAN_SORT(p[17], p[18]); MEDIAN_SORT(p[21], p[22]); MEDIAN_SORT(p[20], p[22]);
+    MEDIAN_SORT(p[20], p[21]); MEDIAN_SORT(p[23], p[24]); MEDIAN_SORT(p[2], p[5]);
+    MEDIAN_SORT(p[3], p[6]);   MEDIAN_SORT(p[0], p[6]);   MEDIAN_SORT(p[0], p[3]);
+    MEDIAN_SORT(p[4], p[7]);   MEDIAN_SORT(p[1], p[7]);   MEDIAN_SORT(p[1], p[4]);
+    MEDIAN_SORT(p[11], p[14]); MEDIAN_SORT(p[8], p[14]);  MEDIAN_SORT(p[8], p[11]);
+    MEDIAN_SORT(p[12], p[15]); MEDIAN_SORT(p[9], p[15]);  MEDIAN_SORT(p[9], p[12]);
+    MEDIAN_SORT(p[13], p[16]); MEDIAN_SORT(p[10], p[16]); MEDIAN_SORT(p[10], p[13]);
+    MEDIAN_SORT(p[20], p[23]); MEDIAN_SORT(p[17], p[23]); MEDIAN_SORT(p[17], p[20]);
+    MEDIAN_SORT(p[21], p[24]); MEDIAN_SORT(p[18], p[24]); MEDIAN_SORT(p[18], p[21]);
+    MEDIAN_SORT(p[19], p[22]); MEDIAN_SORT(p[8], p[17]);  MEDIAN_SORT(p[9], p[18]);
+    MEDIAN_SORT(p[0], p[18]);  MEDIAN_SORT(p[0], p[9]);   MEDIAN_SORT(p[10], p[19]);
+    MEDIAN_SORT(p[1], p[19]);  MEDIAN_SORT(p[1], p[10]);  MEDIAN_SORT(p[11], p[20]);
+    MEDIAN_SORT(p[2], p[20]);  MEDIAN_SORT(p[2], p[11]);  MEDIAN_SORT(p[12], p[21]);
+    MEDIAN_SORT(p[3], p[21]);  MEDIAN_SORT(p[3], p[12]);  MEDIAN_SORT(p[13], p[22]);
+    MEDIAN_SORT(p[4], p[22]);  MEDIAN_SORT(p[4], p[13]);  MEDIAN_SORT(p[14], p[23]);
+    MEDIAN_SORT(p[5], p[23]);  MEDIAN_SORT(p[5], p[14]);  MEDIAN_SORT(p[15], p[24]);
+    MEDIAN_SORT(p[6], p[24]);  MEDIAN_SORT(p[6], p[15]);  MEDIAN_SORT(p[7], p[16]);
+    MEDIAN_SORT(p[7], p[19]);  MEDIAN_SORT(p[13], p[21]); MEDIAN_SORT(p[15], p[23]);
+    MEDIAN_SORT(p[7], p[13]);  MEDIAN_SORT(p[7], p[15]);  MEDIAN_SORT(p[1], p[9]);
+    MEDIAN_SORT(p[3], p[11]);  MEDIAN_SORT(p[5], p[17]);  MEDIAN_SORT(p[11], p[17]);
+    MEDIAN_SORT(p[9], p[17]);  MEDIAN_SORT(p[4], p[10]);  MEDIAN_SORT(p[6], p[12]);
+    MEDIAN_SORT(p[7], p[14]);  MEDIAN_SORT(p[4], p[6]);   MEDIAN_SORT(p[4], p[7]);
+    MEDIAN_SORT(p[12], p[14]); MEDIAN_SORT(p[10], p[14]); MEDIAN_SORT(p[6], p[7]);
+    MEDIAN_SORT(p[10], p[12]); MEDIAN_SORT(p[6], p[10]);  MEDIAN_SORT(p[6], p[17]);
+    MEDIAN_SORT(p[12], p[17]); MEDIAN_SORT(p[7], p[17]);  MEDIAN_SORT(p[7], p[10]);
+    MEDIAN_SORT(p[12], p[18]); MEDIAN_SORT(p[7], p[12]);  MEDIAN_SORT(p[10], p[18]);
+    MEDIAN_SORT(p[12], p[20]); MEDIAN_SORT(p[10], p[20]); MEDIAN_SORT(p[10], p[12]);
+    return p[12];
+}
+
+#undef MEDIAN_SORT
+
+/*
+    * Mediana dos valores válidos de uma janela que fica parcialmente fora da imagem.
+    * Assim como no filtro original, apenas os pixels dentro da imagem entram na janela (não há zero-padding).
+    * @param values Vetor com os `n` valores da janela (é reordenado)
+    * @param n Quantidade de valores
+    * @returns: valor na posição n / 2 dos valores ordenados
+*/
+inline uchar median_of(uchar* values, int n) {
+    nth_element(values, values + n / 2, values + n);
+    return values[n / 2];
+}
+
+/*
+    * Filtro de mediana por redes de ordenação, para raios pequenos (1 -> 3x3, 2 -> 5x5).
+    * Nos pixels cuja janela está inteira dentro da imagem usa a rede fixa, e nas bordas usa `median_of`.
+    * A mediana considera apenas os pixels dentro da imagem, então aqui não se usa a borda de zeros.
+    *
+    * @param src Imagem de entrada (CV_8UC1 ou CV_8UC3)
+    * @param dst Imagem de saída, do mesmo tamanho e tipo de `src`
+    * @param region Região da imagem a ser processada
+    * @param radius Raio da janela (1 ou 2)
+    * @param channel Canal a ser filtrado (os demais canais de `dst` não são alterados)
+    * @returns: void
+*/
+inline void median_sorting_network(const Mat& src, Mat& dst, Region region, int radius, int channel) {
+    const int width = src.cols;
+    const int height = src.rows;
+    const int cn = src.channels();
+
+    uchar window[25];
+
+    // Interior: a janela inteira está dentro da imagem, então usa a rede fixa
+    auto interior = [&](int y, int x_begin, int x_end) {
+        uchar* output_row = dst.ptr<uchar>(y);
+        for (int x = x_begin; x <= x_end; x++) {
+            int n = 0;
+            for (int yy = y - radius; yy <= y + radius; yy++) {
+                const uchar* input_row = src.ptr<uchar>(yy) + channel;
+                for (int xx = x - radius; xx <= x + radius; xx++) {
+                    window[n++] = input_row[xx * cn];
+                }
+            }
+            output_row[x * cn + channel] = (radius == 1) ? median_network9(window) : median_network25(window);
+        }
+    };
+
+    // Borda: coleta apenas os valores da janela que estão dentro da imagem
+    auto border = [&](int y, int x_begin, int x_end) {
+        uchar* output_row = dst.ptr<uchar>(y);
+        for (int x = x_begin; x <= x_end; x++) {
+            int n = 0;
+            for (int yy = max(0, y - radius); yy <= min(height - 1, y + radius); yy++) {
+                const uchar* input_row = src.ptr<uchar>(yy) + channel;
+                for (int xx = max(0, x - radius); xx <= min(width - 1, x + radius); xx++) {
+                    window[n++] = input_row[xx * cn];
+                }
+            }
+            output_row[x * cn + channel] = median_of(window, n);
+        }
+    };
+
+    for_each_row_split(region, radius, width, height, interior, border);
+}
+
+/*
+    * Filtro de mediana por histogramas (estilo Huang / Perreault-Hébert), com custo O(1) por pixel.
+    *
+    * Cada coluna da imagem tem um histograma de 256 posições com os pixels das linhas da janela atual,
+    * atualizado a cada linha somando a linha que entra e removendo a que sai. O histograma da janela é a soma
+    * dos histogramas das colunas, e desliza na horizontal somando a coluna que entra e subtraindo a que sai.
+    * Um histograma grosso de 16 posições (uma para cada 16 tons) acelera a busca pela mediana.
+    *
+    * @param src Imagem de entrada (CV_8UC1 ou CV_8UC3)
+    * @param dst Imagem de saída, do mesmo tamanho e tipo de `src`
+    * @param region Região da imagem a ser processada
+    * @param radius Raio da janela
+    * @param channel Canal a ser filtrado (os demais canais de `dst` não são alterados)
+    * @returns: void
+*/
+inline void median_histogram(const Mat& src, Mat& dst, Region region, int radius, int channel) {
+    const int width = src.cols;
+    const int height = src.rows;
+    const int cn = src.channels();
+
+    // colunas da imagem que entram em alguma janela da região
+    const int col_begin = max(0, region.x_begin - radius);
+    const int col_end = min(width - 1, region.x_end + radius);
+    const int num_cols = col_end - col_begin + 1;
+
+    // Histogramas finos (256 tons) e grossos (16 faixas de 16 tons) de cada coluna
+    // Contadores de 16 bits bastam: no máximo (2 * 20 + 1)² = 1681 pixels por janela
+    vector<uint16_t> column_fine((size_t) num_cols * 256, 0);
+    vector<uint16_t> column_coarse((size_t) num_cols * 16, 0);
+
+    // Soma uma linha da imagem nos histogramas das colunas (sign = 1) ou a remove (sign = -1)
+    auto accumulate_row = [&](int y, int sign) {
+        const uchar* input_row = src.ptr<uchar>(y) + col_begin * cn + channel;
+        for (int i = 0; i < num_cols; i++) {
+            uchar value = input_row[i * cn];
+            column_fine[(size_t) i * 256 + value] += sign;
+            column_coarse[(size_t) i * 16 + (value >> 4)] += sign;
+        }
+    };
+
+    // Inicializa os histogramas das colunas com a janela da primeira linha da região
+    for (int y = max(0, region.y_begin - radius); y <= min(height - 1, region.y_begin + radius); y++) {
+        accumulate_row(y, 1);
+    }
+
+    uint16_t fine[256];
+    uint16_t coarse[16];
+
+    for (int y = region.y_begin; y <= region.y_end; y++) {
+        // Para se o job foi cancelado
+        if (CancellationToken::requested()) return;
+
+        // Desliza a janela vertical: entra a linha y + radius e sai a linha y - radius - 1
+        if (y > region.y_begin) {
+            if (y + radius < height) accumulate_row(y + radius, 1);
+            if (y - radius - 1 >= 0) accumulate_row(y - radius - 1, -1);
+        }
+
+        // quantidade de linhas válidas (dentro da imagem) na janela desta linha
+        const int valid_rows = min(height - 1, y + radius) - max(0, y - radius) + 1;
+
+        // Monta o histograma da janela do primeiro pixel da região
+        memset(fine, 0, sizeof(fine));
+        memset(coarse, 0, sizeof(coarse));
+        for (int x = max(0, region.x_begin - radius); x <= min(width - 1, region.x_begin + radius); x++) {
+            const uint16_t* col_fine = &column_fine[(size_t) (x - col_begin) * 256];
+            const uint16_t* col_coarse = &column_coarse[(size_t) (x - col_begin) * 16];
+            for (int b = 0; b < 256; b++) fine[b] += col_fine[b];
+            for (int b = 0; b < 16; b++) coarse[b] += col_coarse[b];
+        }
+
+        uchar* output_row = dst.ptr<uchar>(y);
+
+        for (int x = region.x_begin; x <= region.x_end; x++) {
+            // Desliza a janela horizontal: entra a coluna x + radius e sai a coluna x - radius - 1
+            if (x > region.x_begin) {
+                if (x + radius < width) {
+                    const uint16_t* col_fine = &column_fine[(size_t) (x + radius - col_begin) * 256];
+                    const uint16_t* col_coarse = &column_coarse[(size_t) (x + radius - col_begin) * 16];
+                    for (int b = 0; b < 256; b++) fine[b] += col_fine[b];
+                    for (int b = 0; b < 16; b++) coarse[b] += col_coarse[b];
+                }
+                if (x - radius - 1 >= 0) {
+                    const uint16_t* col_fine = &column_fine[(size_t) (x - radius - 1 - col_begin) * 256];
+                    const uint16_t* col_coarse = &column_coarse[(size_t) (x - radius - 1 - col_begin) * 16];
+                    for (int b = 0; b < 256; b++) fine[b] -= col_fine[b];
+                    for (int b = 0; b < 16; b++) coarse[b] -= col_coarse[b];
+                }
+            }
+
+            // A mediana é o valor na posição n / 2 (começando em 0) dos n pixels válidos da janela
+            const int valid_cols = min(width - 1, x + radius) - max(0, x - radius) + 1;
+            int rank = (valid_rows * valid_cols) / 2;
+
+            // Primeiro encontra a faixa de 16 tons que contém a mediana, depois o tom dentro da faixa
+            int bin = 0;
+            while (rank >= coarse[bin]) {
+                rank -= coarse[bin];
+                bin++;
+            }
+            int value = bin * 16;
+            while (rank >= fine[value]) {
+                rank -= fine[value];
+                value++;
+            }
+
+            output_row[x * cn + channel] = (uchar) value;
+        }
+    }
+}
+
+/*
+    * Aplica o filtro de mediana em um canal da região, escolhendo o método de acordo com o raio:
+    * redes de ordenação para janelas 3x3 e 5x5 e histogramas deslizantes para janelas maiores.
+    *
+    * @param src Imagem de entrada (CV_8UC1 ou CV_8UC3)
+    * @param dst Imagem de saída, do mesmo tamanho e tipo de `src`
+    * @param region Região da imagem a ser processada
+    * @param radius Raio da janela
+    * @param channel Canal a ser filtrado (os demais canais de `dst` não são alterados)
+    * @returns: void
+*/
+inline void median_channel(const Mat& src, Mat& dst, Region region, int radius, int channel) {
+    if (radius >= 1 && radius <= 2)
+        median_sorting_network(src, dst, region, radius, channel);
+    else
+        median_histogram(src, dst, region, radius, channel);
+}
+
+#endif // _MEDIAN_HPP_
@@ -0,0 +1,116 @@
+#ifndef _MPMC_QUEUE_HPP_
+#define _MPMC_QUEUE_HPP_
+
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+using namespace std;
+
+/*
+    * Fila circular limitada, sem locks, com múltiplos produtores e múltiplos consumidores (MPMC).
+    *
+    * Implementação da fila de Dmitry Vyukov: cada célula tem um número de sequência que diz se ela está livre
+    * para o produtor da volta atual ou cheia para o consumidor da volta atual. Produtores e consumidores
+    * reservam posições com compare-and-swap em contadores separados (em linhas de cache separadas),
+    * e nenhum dos dois lados espera o outro terminar.
+*/
+template <typename T>
+class BoundedMpmcQueue {
+    private:
+        struct Cell {
+            atomic<size_t> sequence;
+            T data;
+        };
+
+        // Células da fila (capacidade potência de 2)
+        unique_ptr<Cell[]> cells;
+        size_t mask;
+
+        // Próxima posição a inserir e próxima posição a retirar
+        alignas(64) atomic<size_t> enqueue_pos;
+        alignas(64) atomic<size_t> dequeue_pos;
+
+    public:
+        /*
+            * Construtor da fila.
+            * @param capacity Capacidade da fila (arredondada para a próxima potência de 2)
+        */
+        explicit BoundedMpmcQueue(size_t capacity) : enqueue_pos(0), dequeue_pos(0) {
+            size_t size = 2;
+            while (size < capacity) size <<= 1;
+
+            cells.reset(new Cell[size]);
+            mask = size - 1;
+            for (size_t i = 0; i < size; i++) cells[i].sequence.store(i, memory_order_relaxed);
+        }
+
+        BoundedMpmcQueue(const BoundedMpmcQueue&) = delete;
+        BoundedMpmcQueue& operator=(const BoundedMpmcQueue&) = delete;
+
+        /*
+            * Tenta inserir um elemento.
+            * @param item Elemento a ser inserido
+            * @return false se a fila estiver cheia
+        */
+        bool try_push(const T& item) {
+            size_t pos = enqueue_pos.load(memory_order_relaxed);
+            Cell* cell;
+
+            while (true) {
+                cell = &cells[pos & mask];
+                size_t sequence = cell->sequence.load(memory_order_acquire);
+                intptr_t diff = (intptr_t) sequence - (intptr_t) pos;
+
+                if (diff == 0) {
+                    // Célula livre nesta volta: tenta reservá-la
+                    if (enqueue_pos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) break;
+                } else if (diff < 0) {
+                    return false; // fila cheia
+                } else {
+                    pos = enqueue_pos.load(memory_order_relaxed); // outro produtor reservou antes
+                }
+            }
+
+            cell->data = item;
+            cell->sequence.store(pos + 1, memory_order_release);
+            return true;
+        }
+
+        /*
+            * Tenta retirar um elemento.
+            * @param item Recebe o elemento retirado
+            * @return false se a fila estiver vazia
+        */
+        bool try_pop(T& item) {
+            size_t pos = dequeue_pos.load(memory_order_relaxed);
+            Cell* cell;
+
+            while (true) {
+                cell = &cells[pos & mask];
+                size_t sequence = cell->sequence.load(memory_order_acquire);
+                intptr_t diff = (intptr_t) sequence - (intptr_t) (pos + 1);
+
+                if (diff == 0) {
+                    // Célula cheia nesta volta: tenta reservá-la
+                    if (dequeue_pos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) break;
+                } else if (diff < 0) {
+                    return false; // fila vazia
+                } else {
+                    pos = dequeue_pos.load(memory_order_relaxed); // outro consumidor reservou antes
+                }
+            }
+
+            item = cell->data;
+            cell->sequence.store(pos + mask + 1, memory_order_release);
+            return true;
+        }
+
+        // Capacidade da fila
+        size_t capacity() const {
+            return mask + 1;
+        }
+};
+
+#endif // _MPMC_QUEUE_HPP_
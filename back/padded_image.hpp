@@ -0,0 +1,55 @@
+#ifndef _PADDED_IMAGE_HPP_
+#define _PADDED_IMAGE_HPP_
+
+#include <opencv2/opencv.hpp>
+
+using namespace cv;
+
+/*
+    * Cópia da imagem de entrada com uma borda (halo) de zeros ao redor.
+    *
+    * Os filtros de vizinhança usam zero-padding: vizinhos fora da imagem contam como zero.
+    * Com a borda de zeros já na memória, os laços internos podem ler os vizinhos diretamente,
+    * sem testar a cada vizinho se ele está dentro da imagem, desde que o raio da vizinhança
+    * não passe de `padding`.
+    *
+    * A cópia é montada uma vez por imagem recebida e reaproveitada em todos os processamentos.
+*/
+struct PaddedImage {
+    // imagem com a borda de zeros (height + 2 * padding linhas, width + 2 * padding colunas)
+    Mat data;
+
+    // largura da borda, em pixels, em cada lado
+    int padding = 0;
+
+    // tamanho e canais da imagem original
+    int width = 0;
+    int height = 0;
+    int cn = 1;
+
+    /*
+        * Monta a cópia com borda de zeros da imagem.
+        * @param image Imagem original (CV_8UC1 ou CV_8UC3)
+        * @param padding Largura da borda
+        * @returns: void
+    */
+    void build(const Mat& image, int padding) {
+        copyMakeBorder(image, this->data, padding, padding, padding, padding, BORDER_CONSTANT, Scalar::all(0));
+        this->padding = padding;
+        this->width = image.cols;
+        this->height = image.rows;
+        this->cn = image.channels();
+    }
+
+    /*
+        * Retorna o ponteiro para o pixel (0, y) da imagem original.
+        * Aceita y em [-padding, height + padding) e deslocamentos de -padding a width + padding - 1 pixels na linha.
+        * @param y Linha da imagem original
+        * @returns: ponteiro para o primeiro byte do pixel (0, y)
+    */
+    const uchar* row(int y) const {
+        return this->data.ptr<uchar>(y + this->padding) + this->padding * this->cn;
+    }
+};
+
+#endif // _PADDED_IMAGE_HPP_
@@ -0,0 +1,15 @@
+#ifndef _REGION_HPP_
+#define _REGION_HPP_
+
+/*
+    * Região retangular da imagem a ser processada por uma thread.
+    * Os limites são inclusivos: x_begin..x_end (colunas) e y_begin..y_end (linhas).
+*/
+typedef struct Region{
+    int x_begin;
+    int x_end;
+    int y_begin;
+    int y_end;
+} Region;
+
+#endif // _REGION_HPP_
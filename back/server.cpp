@@ -4,10 +4,22 @@
 #include <thread>
 #include "httplib.h"
 #include "image.hpp"
+#include "job_manager.hpp"
+#include "image_cache.hpp"
 
 using namespace std;
 using namespace cv;
 
+// Threads do servidor HTTP. Cada conexão de eventos (/events) ocupa uma enquanto o job roda, então são bem mais que as CPUs
+#define SERVER_HTTP_THREADS 128
+
+// Máximo de conexões seguradas ao mesmo tempo: conexões de eventos e consultas longas (`wait`) somadas.
+// Além disso, as conexões de eventos são recusadas (503) e as consultas longas respondem na hora, sem esperar.
+// As threads restantes (SERVER_HTTP_THREADS - SERVER_MAX_HELD_CONNECTIONS) ficam sempre livres para as outras requisições
+#define SERVER_MAX_HELD_CONNECTIONS 96
+
+// Espera máxima, em milissegundos, de uma consulta longa (`wait` maiores são reduzidos a esse valor)
+#define SERVER_MAX_WAIT_MS 5000
 
 /*
     * Função auxiliar para ler arquivos do frontend
@@ -25,9 +37,102 @@ string read_frontend_file(const string& filename) {
     return buffer.str();
 }
 
+/*
+    * Função auxiliar para codificar bytes em base64 (usada para enviar os blocos das imagens dentro de um JSON)
+    * @param bytes Bytes a serem codificados
+    * @return Texto em base64
+*/
+string base64_encode(const vector<uchar>& bytes) {
+    static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    string out;
+    out.reserve((bytes.size() + 2) / 3 * 4);
+    for (size_t i = 0; i < bytes.size(); i += 3) {
+        uint32_t chunk = bytes[i] << 16;
+        if (i + 1 < bytes.size()) chunk |= bytes[i + 1] << 8;
+        if (i + 2 < bytes.size()) chunk |= bytes[i + 2];
+        out += table[(chunk >> 18) & 63];
+        out += table[(chunk >> 12) & 63];
+        out += i + 1 < bytes.size() ? table[(chunk >> 6) & 63] : '=';
+        out += i + 2 < bytes.size() ? table[chunk & 63] : '=';
+    }
+    return out;
+}
+
+/*
+    * Função auxiliar para conferir o cabeçalho If-None-Match de uma requisição
+    * @param req Requisição recebida
+    * @param etag ETag atual do recurso (entre aspas)
+    * @return true se o cliente já tem essa versão (a resposta pode ser 304 Not Modified)
+*/
+bool etag_matches(const httplib::Request& req, const string& etag) {
+    if (!req.has_header("If-None-Match")) return false;
+
+    // Lista de ETags separadas por vírgula; "*" vale para qualquer uma, e o prefixo W/ é ignorado na comparação
+    stringstream ss(req.get_header_value("If-None-Match"));
+    string candidate;
+    while (getline(ss, candidate, ',')) {
+        size_t begin = candidate.find_first_not_of(" \t");
+        size_t end = candidate.find_last_not_of(" \t");
+        if (begin == string::npos) continue;
+        candidate = candidate.substr(begin, end - begin + 1);
+        if (candidate.rfind("W/", 0) == 0) candidate = candidate.substr(2);
+        if (candidate == "*" || candidate == etag) return true;
+    }
+    return false;
+}
+
+/*
+    * Função auxiliar para ler um corpo multipart/form-data conforme ele chega, sem guardar o corpo inteiro antes
+    * Cada campo vai direto para `fields`; um campo de arquivo (a imagem) reserva de uma vez o tamanho do corpo, sem realocações
+    * @param req Requisição recebida
+    * @param content_reader Leitor do corpo da requisição
+    * @param fields Recebe o conteúdo de cada campo, pelo nome
+    * @return false se o corpo não for multipart/form-data ou se a leitura falhar
+*/
+bool read_form_fields(const httplib::Request& req, const httplib::ContentReader& content_reader, map<string, string>& fields) {
+    if (!req.is_multipart_form_data()) return false;
+    size_t body_size = req.has_header("Content-Length") ? stoull(req.get_header_value("Content-Length")) : 0;
+
+    string* current = nullptr;
+    return content_reader(
+        [&](const httplib::MultipartFormData& part) {
+            current = &fields[part.name];
+            current->clear();
+            if (!part.filename.empty()) current->reserve(body_size);
+            return true;
+        },
+        [&](const char* data, size_t length) {
+            current->append(data, length);
+            return true;
+        });
+}
+
+/*
+    * Função auxiliar para as consultas longas das imagens de saída: espera a saída terminar por até `wait` milissegundos
+    * (no máximo SERVER_MAX_WAIT_MS), ocupando uma das conexões seguradas. Sem conexão livre, só confere, sem esperar.
+    * @param req Requisição recebida, com o parâmetro `wait`
+    * @param held_connections Conexões seguradas no momento (eventos e consultas longas)
+    * @param wait Espera pela saída, com o tempo máximo em milissegundos; retorna se ela terminou
+    * @return true se a saída terminou
+*/
+bool wait_for_output(const httplib::Request& req, atomic<int>& held_connections, const function<bool(int)>& wait) {
+    int wait_ms = clamp(stoi(req.get_param_value("wait")), 0, SERVER_MAX_WAIT_MS);
+    if (held_connections.fetch_add(1) >= SERVER_MAX_HELD_CONNECTIONS) wait_ms = 0;
+    bool done = wait(wait_ms);
+    held_connections.fetch_sub(1);
+    return done;
+}
+
 int main(){
     httplib::Server server;
-    shared_ptr<Image> img = make_shared<Image>();
+    server.new_task_queue = [] { return new httplib::ThreadPool(SERVER_HTTP_THREADS); };
+
+    // Conexões seguradas no momento: conexões de eventos abertas e consultas longas esperando
+    atomic<int> held_connections{0};
+    // Um único pool de threads, dividido entre os processamentos (jobs) de todos os usuários
+    JobManager jobs(make_shared<ThreadPool>(effective_cpu_count(), pin_threads_from_env()));
+    // Imagens já enviadas, decodificadas, reaproveitadas pelos processamentos seguintes
+    ImageCache images(IMAGE_CACHE_MAX_BYTES);
 
     /*
         * Configuração do servidor HTTP
@@ -113,40 +218,95 @@ int main(){
         res.set_content(image_content, "image/png");
     });
 
+    /*
+        * Endpoint para enviar uma imagem uma única vez, antes de processá-la (com um ou mais filtros)
+        * A imagem é decodificada e guardada na memória; os processamentos seguintes a usam pelo handle,
+        * sem transferir nem decodificar a imagem de novo.
+
+        @params:
+            - image: imagem a ser guardada (formato binário)
+
+        * @returns:
+            - handle: identificador da imagem (resumo SHA-256 do conteúdo), a ser passado como `imageHandle` para /process (JSON)
+    */
+    server.Post("/images", [&images](const httplib::Request& req, httplib::Response& res, const httplib::ContentReader& content_reader) {
+        map<string, string> fields;
+        if (!read_form_fields(req, content_reader, fields) || !fields.count("image")) {
+            res.status = 400;
+            res.set_content(R"({"error": "no image uploaded"})", "application/json");
+            return;
+        }
+
+        try{
+            const string& image_data = fields["image"];
+            string handle = images.put(reinterpret_cast<const uchar*>(image_data.data()), image_data.size());
+
+            res.status = 200;
+            res.set_content(R"({"handle": ")" + handle + R"("})", "application/json");
+        }catch (exception& e){
+            cout << "Error: " << e.what() << endl;
+            res.status = 400;
+            res.set_content(R"({"error": "invalid image"})", "application/json");
+        }
+    });
+
     /*
         * Endpoint para processar a imagem recebida do frontend
         
         @params:
-            - image: imagem a ser processada (formato binário)
-            - intensity: intensidade do filtro (inteiro)
+            - image: imagem a ser processada (formato binário); pode ser omitida se `imageHandle` for enviado
+            - imageHandle: handle de uma imagem enviada antes para /images (string, opcional)
+            - intensity: intensidade do filtro (inteiro, de MIN_FILTER_INTENSITY a MAX_FILTER_INTENSITY)
             - qtdThreads: quantidade de threads a serem utilizadas (inteiro)
             - filter: tipo de filtro a ser aplicado (string)
             - colorOption: opção de cor da imagem (string)
             - filetype: tipo de arquivo da imagem (string)
+            - arithmetic: aritmética das convoluções, "float" ou "fixed" (string, opcional, padrão "float").
+              Em "float", o gaussiano de raio a partir de RECURSIVE_GAUSSIAN_MIN_RADIUS usa o filtro recursivo, que é aproximado:
+              nesses raios ele pode diferir em vários níveis do "fixed", que sempre faz a convolução
+            - tileSize: lado, em pixels, dos blocos divididos entre as threads (inteiro, opcional, padrão 128)
+            - replaces: número de um job anterior do mesmo usuário, que é cancelado (inteiro, opcional)
+            - replacesToken: token do job anterior, retornado por /process junto com o número; sem ele, o job anterior não é cancelado (string, opcional)
+            - priority: classe de prioridade do job no pool de threads, "interactive", "normal" ou "batch" (string, opcional, padrão "normal")
+            - benchmark: "1" para o modo benchmark, em que single e multi-thread rodam um depois do outro, com o pool ocioso (string, opcional)
+            - flushCaches: "1" para esvaziar os caches antes de cada medida do modo benchmark (string, opcional)
 
         * O servidor espera receber uma imagem no formato form-data com os parâmetros acima.
 
-        * O servidor chama a função `process` da classe `Image` para aplicar o filtro na imagem recebida.
-        * O servidor retorna um JSON informando se começou a processar a imagem ou se houve erro.
+        * O servidor cria um job isolado (com a sua própria classe `Image`) e chama a função `process` dele para aplicar o filtro na imagem recebida.
+        * O servidor retorna um JSON com o número do job (jobId) e o token dele (jobToken), exigidos juntos para buscar as imagens
+        * processadas, acompanhar o progresso e substituir o job depois, ou informando se houve erro.
+        * Se o handle não existir mais (a imagem foi descartada da memória), a resposta é 404: o frontend deve enviar a imagem de novo.
+        * Se todas as vagas de jobs (JOB_MANAGER_MAX_JOBS) estiverem ocupadas por jobs rodando ou cujas saídas ainda não foram buscadas,
+        * a resposta é 503: o frontend deve tentar de novo mais tarde.
     */
-    server.Post("/process", [&img](const httplib::Request& req, httplib::Response& res) {
+    server.Post("/process", [&jobs, &images](const httplib::Request& req, httplib::Response& res, const httplib::ContentReader& content_reader) {
         try{
-            auto it = req.files.find("image");
-            if (it == req.files.end()) {
+            // Lê o form-data conforme ele chega: a imagem fica guardada uma única vez, no próprio campo
+            map<string, string> fields;
+            if (!read_form_fields(req, content_reader, fields)) {
+                res.status = 400;
+                res.set_content(R"({"error": "bad request!"})", "application/json");
+                return;
+            }
+
+            auto image_field = fields.find("image");
+            if (image_field == fields.end() && !fields.count("imageHandle")) {
                 res.status = 400;
                 res.set_content(R"({"error": "no image uploaded"})", "application/json");
                 return;
             }
-            const auto& file = it->second;
-            const std::string& image_data = file.content;
             
-            // Função auxiliar para extrair campos do form-data
+            // Funções auxiliares para extrair campos do form-data
             auto get_form_field = [&](const std::string& name) -> std::string {
-                auto it = req.files.find(name);
-                if (it == req.files.end()) {
+                auto it = fields.find(name);
+                if (it == fields.end()) {
                     throw std::runtime_error("Campo '" + name + "' não encontrado");
                 }
-                return it->second.content;
+                return it->second;
+            };
+            auto has_form_field = [&](const std::string& name) {
+                return fields.count(name) > 0;
             };
 
             // Extrai os parâmetros corretamente
@@ -155,21 +315,60 @@ int main(){
             const auto param_filter = get_form_field("filter");
             const auto param_colorOption = get_form_field("colorOption");
             const auto param_filetype = get_form_field("filetype");
-            
-            vector<uchar> buffer(image_data.begin(), image_data.end());
-            
+            const auto param_arithmetic = has_form_field("arithmetic") ? get_form_field("arithmetic") : "float";
+            const auto param_tileSize = has_form_field("tileSize") ? get_form_field("tileSize") : to_string(DEFAULT_TILE_SIZE);
+            const auto param_replaces = has_form_field("replaces") ? get_form_field("replaces") : "0";
+            const auto param_replacesToken = has_form_field("replacesToken") ? get_form_field("replacesToken") : "";
+            const auto param_priority = has_form_field("priority") ? get_form_field("priority") : "normal";
+            const auto param_benchmark = has_form_field("benchmark") ? get_form_field("benchmark") : "0";
+            const auto param_flushCaches = has_form_field("flushCaches") ? get_form_field("flushCaches") : "0";
             
             cout << endl << "Image received!";
 
-            // Carrega os dados recebidos no objeto da classe Image
-            img->overwriteImage(buffer, stringToImageColorType(param_colorOption), stringToImageType(param_filetype));
-
-            // Inicia o processamento da imagem com os parâmetros recebidos
-            img->process(param_filter, stoi(param_qtdThreads), stoi(param_intensity));
+            // Cria um job com os dados recebidos e inicia o processamento da imagem com os parâmetros recebidos
+            JobRequest request;
+            request.color_type = stringToImageColorType(param_colorOption);
+            if (image_field != fields.end()) {
+                // A imagem é decodificada direto dos bytes recebidos, sem cópia
+                request.data = reinterpret_cast<const uchar*>(image_field->second.data());
+                request.size = image_field->second.size();
+            } else {
+                // Imagem enviada antes: já decodificada, no tipo de cor pedido
+                request.data = nullptr;
+                request.size = 0;
+                request.decoded = images.get(get_form_field("imageHandle"), request.color_type);
+                if (request.decoded.empty()) {
+                    res.status = 404;
+                    res.set_content(R"({"error": "image handle not found"})", "application/json");
+                    return;
+                }
+            }
+            request.type = stringToImageType(param_filetype);
+            request.filter = param_filter;
+            request.threads = stoi(param_qtdThreads);
+            request.intensity = stoi(param_intensity);
+            if (request.intensity < MIN_FILTER_INTENSITY || request.intensity > MAX_FILTER_INTENSITY) {
+                res.status = 400;
+                res.set_content(R"({"error": "invalid intensity"})", "application/json");
+                return;
+            }
+            request.path = stringToConvolutionPath(param_arithmetic);
+            request.tile_size = stoi(param_tileSize);
+            request.priority = stringToTaskPriority(param_priority);
+            request.benchmark = param_benchmark == "1";
+            request.flush_caches = param_flushCaches == "1";
+            JobTicket job = jobs.create(request, stoi(param_replaces), param_replacesToken);
+            if (job.id == 0) {
+                // Todas as vagas de jobs estão ocupadas por jobs rodando ou esperando a busca das saídas
+                res.status = 503;
+                res.set_content(R"({"error": "server busy"})", "application/json");
+                return;
+            }
 
-            // Retorna um json com o status_code e a mensagem de que comecou a processar a imagem
+            // Retorna um json com o status_code, a mensagem de que comecou a processar a imagem e o número e o token do job
             res.status = 200;
-            string json_response = R"({"message": "Image processed successfully!"})";
+            string json_response = R"({"message": "Image processed successfully!", "jobId": )" + to_string(job.id)
+                + R"(, "jobToken": ")" + job.token + R"("})";
             res.set_content(json_response, "application/json");
         }catch (exception& e){
             // Se faltou parametro, avisa
@@ -183,17 +382,62 @@ int main(){
     /*
         * Endpoint para obter a imagem processada em um único thread
         * Através dessa função, o front-end acompanha o progresso do processamento da imagem em uma thread única.
+        *
+        * @params:
+            - jobId: número do job, retornado por /process (inteiro)
+            - jobToken: token do job, retornado por /process junto com o número; sem o token certo, a resposta é 404 (string)
+            - wait: tempo máximo, em milissegundos, para esperar o processamento terminar (inteiro, opcional, até SERVER_MAX_WAIT_MS)
         * 
         * @returns:
             - done: booleano indicando se o processamento foi concluído (cabeçalho)
             - duration: duração do processamento em milissegundos (cabeçalho)
+            - cancel-latency: latência do último cancelamento de um job substituído, em milissegundos, ou -1 se nenhum (cabeçalho)
+            - ETag: hash da imagem final codificada, só depois que o processamento termina; com If-None-Match igual, a resposta é 304 (cabeçalho)
             - image: imagem processada (formato binário)
+        *
+        * Com `wait`, se o processamento não terminar a tempo, a resposta é 204, só com os cabeçalhos `done` e `duration`:
+        * a imagem parcial não é codificada (o progresso vem de /getProgress).
     */
-    server.Get("/getSingleThreadImage", [&img](const httplib::Request& req, httplib::Response& res) {
+    server.Get("/getSingleThreadImage", [&jobs, &held_connections](const httplib::Request& req, httplib::Response& res) {
         try{
-            bool single_thread_done  = img->get_single_thread_done();
+            int job_id = stoi(req.get_param_value("jobId"));
+            shared_ptr<Image> img = jobs.get(job_id, req.get_param_value("jobToken"));
+            if (!img) {
+                res.status = 404;
+                res.set_content(R"({"error": "job not found"})", "application/json");
+                return;
+            }
+
+            // Com o parâmetro `wait`, espera o processamento terminar por até `wait` milissegundos antes de responder
+            // (responde assim que o processamento termina, sem precisar consultar de novo)
+            bool single_thread_done = req.has_param("wait")
+                ? wait_for_output(req, held_connections, [&](int ms) { return img->wait_single_thread(ms); })
+                : img->get_single_thread_done();
             double single_thread_duration = img->get_single_thread_duration(single_thread_done);
-            vector<uchar> single_thread_image = img->get_single_thread_image();
+
+            // A espera acabou antes do fim: responde só os cabeçalhos, sem codificar a imagem parcial
+            if (req.has_param("wait") && !single_thread_done) {
+                res.status = 204;
+                res.set_header("done", to_string(single_thread_done));
+                res.set_header("duration", to_string(single_thread_duration));
+                return;
+            }
+
+            // Concluído: a imagem já foi codificada uma única vez e tem ETag; se o cliente já tem essa versão, responde 304 sem corpo
+            // A saída final foi buscada (com 200 ou 304): o job pode ser descartado para dar lugar a outro
+            shared_ptr<const EncodedImage> result = single_thread_done ? img->get_encoded_result(false) : nullptr;
+            if (result) {
+                res.set_header("ETag", result->etag);
+                res.set_header("Cache-Control", "no-cache");
+                jobs.mark_served(job_id, false);
+            }
+            if (result && etag_matches(req, result->etag)) {
+                res.status = 304;
+                res.set_header("done", to_string(single_thread_done));
+                res.set_header("duration", to_string(single_thread_duration));
+                return;
+            }
+            vector<uchar> single_thread_image = result ? vector<uchar>() : img->get_single_thread_image();
 
 
             res.status = 200;
@@ -201,9 +445,11 @@ int main(){
             res.set_header("Content-Type", "image/" + img->get_image_type());  // Defina o tipo de imagem correto (pode ser PNG, JPEG, etc.)
             res.set_header("done", to_string(single_thread_done));  // Adiciona "done" como cabeçalho
             res.set_header("duration", to_string(single_thread_duration));  // Adiciona "duration" como cabeçalho
+            res.set_header("cancel-latency", to_string(jobs.get_last_cancel_latency()));
 
             // Envia os bytes da imagem diretamente no corpo da resposta
-            res.set_content(reinterpret_cast<const char*>(single_thread_image.data()), single_thread_image.size(), "image/" + img->get_image_type());  // Defina o tipo de imagem correto (pode ser PNG, JPEG, etc.)
+            const vector<uchar>& single_thread_bytes = result ? result->bytes : single_thread_image;
+            res.set_content(reinterpret_cast<const char*>(single_thread_bytes.data()), single_thread_bytes.size(), "image/" + img->get_image_type());  // Defina o tipo de imagem correto (pode ser PNG, JPEG, etc.)
         }catch(exception& e){
             // Se faltou parametro, avisa
             cout << "Error: " << e.what() << endl;
@@ -216,17 +462,65 @@ int main(){
     /*
         * Endpoint para obter a imagem processada em múltiplas threads
         * Através dessa função, o front-end acompanha o progresso do processamento da imagem em múltiplas threads.
+        *
+        * @params:
+            - jobId: número do job, retornado por /process (inteiro)
+            - jobToken: token do job, retornado por /process junto com o número; sem o token certo, a resposta é 404 (string)
+            - wait: tempo máximo, em milissegundos, para esperar o processamento terminar (inteiro, opcional, até SERVER_MAX_WAIT_MS)
         * 
         * @returns:
             - done: booleano indicando se o processamento foi concluído (cabeçalho)
             - duration: duração do processamento em milissegundos (cabeçalho)
+            - cancel-latency: latência do último cancelamento de um job substituído, em milissegundos, ou -1 se nenhum (cabeçalho)
+            - tiles-per-worker: quantidade de blocos processados por cada thread, separados por vírgula (cabeçalho)
+            - speedup: duração single-thread / duração multi-thread, só no modo benchmark, ou -1 (cabeçalho)
+            - efficiency: eficiência paralela (speedup / threads), só no modo benchmark, ou -1 (cabeçalho)
+            - ETag: hash da imagem final codificada, só depois que o processamento termina; com If-None-Match igual, a resposta é 304 (cabeçalho)
             - image: imagem processada (formato binário)
+        *
+        * Com `wait`, se o processamento não terminar a tempo, a resposta é 204, só com os cabeçalhos `done` e `duration`:
+        * a imagem parcial não é codificada (o progresso vem de /getProgress).
     */
-    server.Get("/getMultiThreadImage", [&img](const httplib::Request& req, httplib::Response& res) {
+    server.Get("/getMultiThreadImage", [&jobs, &held_connections](const httplib::Request& req, httplib::Response& res) {
         try{
-            bool multi_thread_done = img->get_multi_thread_done();
+            int job_id = stoi(req.get_param_value("jobId"));
+            shared_ptr<Image> img = jobs.get(job_id, req.get_param_value("jobToken"));
+            if (!img) {
+                res.status = 404;
+                res.set_content(R"({"error": "job not found"})", "application/json");
+                return;
+            }
+
+            // Com o parâmetro `wait`, espera o processamento terminar por até `wait` milissegundos antes de responder
+            // (responde assim que o processamento termina, sem precisar consultar de novo)
+            bool multi_thread_done = req.has_param("wait")
+                ? wait_for_output(req, held_connections, [&](int ms) { return img->wait_multi_thread(ms); })
+                : img->get_multi_thread_done();
             double multi_thread_duration = img->get_multi_thread_duration(multi_thread_done);
-            vector<uchar> multi_thread_image = img->get_multi_thread_image();
+
+            // A espera acabou antes do fim: responde só os cabeçalhos, sem codificar a imagem parcial
+            if (req.has_param("wait") && !multi_thread_done) {
+                res.status = 204;
+                res.set_header("done", to_string(multi_thread_done));
+                res.set_header("duration", to_string(multi_thread_duration));
+                return;
+            }
+
+            // Concluído: a imagem já foi codificada uma única vez e tem ETag; se o cliente já tem essa versão, responde 304 sem corpo
+            // A saída final foi buscada (com 200 ou 304): o job pode ser descartado para dar lugar a outro
+            shared_ptr<const EncodedImage> result = multi_thread_done ? img->get_encoded_result(true) : nullptr;
+            if (result) {
+                res.set_header("ETag", result->etag);
+                res.set_header("Cache-Control", "no-cache");
+                jobs.mark_served(job_id, true);
+            }
+            if (result && etag_matches(req, result->etag)) {
+                res.status = 304;
+                res.set_header("done", to_string(multi_thread_done));
+                res.set_header("duration", to_string(multi_thread_duration));
+                return;
+            }
+            vector<uchar> multi_thread_image = result ? vector<uchar>() : img->get_multi_thread_image();
 
 
             res.status = 200;
@@ -234,7 +528,18 @@ int main(){
             res.set_header("Content-Type", "image/" + img->get_image_type());  // Defina o tipo de imagem correto (pode ser PNG, JPEG, etc.)
             res.set_header("done", to_string(multi_thread_done));  // Adiciona "done" como cabeçalho
             res.set_header("duration", to_string(multi_thread_duration));  // Adiciona "duration" como cabeçalho
-            res.set_content(reinterpret_cast<const char*>(multi_thread_image.data()), multi_thread_image.size(), "image/" + img->get_image_type());  // Defina o tipo de imagem correto (pode ser PNG, JPEG, etc.)
+            res.set_header("cancel-latency", to_string(jobs.get_last_cancel_latency()));
+
+            // Adiciona a quantidade de blocos de cada thread como cabeçalho (ex.: "12,11,13")
+            string tiles_per_worker;
+            for (int count : img->get_tiles_per_worker()) {
+                tiles_per_worker += (tiles_per_worker.empty() ? "" : ",") + to_string(count);
+            }
+            res.set_header("tiles-per-worker", tiles_per_worker);
+            res.set_header("speedup", to_string(img->get_speedup()));
+            res.set_header("efficiency", to_string(img->get_parallel_efficiency()));
+            const vector<uchar>& multi_thread_bytes = result ? result->bytes : multi_thread_image;
+            res.set_content(reinterpret_cast<const char*>(multi_thread_bytes.data()), multi_thread_bytes.size(), "image/" + img->get_image_type());  // Defina o tipo de imagem correto (pode ser PNG, JPEG, etc.)
         }catch(exception& e){
             // Se faltou parametro, avisa
             cout << "Error: " << e.what() << endl;
@@ -244,17 +549,177 @@ int main(){
         }
     });
 
+    /*
+        * Endpoint para acompanhar o progresso de um processamento sem baixar a imagem inteira a cada consulta.
+        * Retorna só os blocos da saída concluídos desde a última consulta, cada um codificado em PNG uma única vez.
+        * A imagem inteira deve ser buscada (em /getSingleThreadImage ou /getMultiThreadImage) só quando `done` for 1.
+        *
+        * @params:
+            - jobId: número do job, retornado por /process (inteiro)
+            - jobToken: token do job, retornado por /process junto com o número; sem o token certo, a resposta é 404 (string)
+            - output: saída acompanhada, "single" ou "multi" (string)
+            - since: número de sequência retornado pela consulta anterior (inteiro, opcional, padrão 0)
+        *
+        * @returns:
+            - sequence: número de sequência atual, a ser passado como `since` na próxima consulta (JSON)
+            - done: 1 se o processamento da saída foi concluído; nesse caso, todos os blocos que faltavam estão na resposta (JSON)
+            - duration: duração do processamento em milissegundos (JSON)
+            - width, height: dimensões da imagem (JSON)
+            - tiles: blocos que mudaram, com a posição (x, y), as dimensões e o PNG em base64 (JSON)
+    */
+    server.Get("/getProgress", [&jobs](const httplib::Request& req, httplib::Response& res) {
+        try{
+            shared_ptr<Image> img = jobs.get(stoi(req.get_param_value("jobId")), req.get_param_value("jobToken"));
+            if (!img) {
+                res.status = 404;
+                res.set_content(R"({"error": "job not found"})", "application/json");
+                return;
+            }
+
+            bool multi = req.get_param_value("output") == "multi";
+            uint64_t since = req.has_param("since") ? stoull(req.get_param_value("since")) : 0;
+
+            // Confere se terminou antes de pegar os blocos: se terminou, nenhum bloco fica de fora da resposta
+            bool done = multi ? img->get_multi_thread_done() : img->get_single_thread_done();
+            double duration = multi ? img->get_multi_thread_duration(done) : img->get_single_thread_duration(done);
+            uint64_t sequence;
+            vector<TileUpdate> updates = img->get_tile_updates(multi, since, sequence);
+
+            string json_response = R"({"sequence": )" + to_string(sequence) + R"(, "done": )" + to_string(done)
+                + R"(, "duration": )" + to_string(duration) + R"(, "width": )" + to_string(img->get_width())
+                + R"(, "height": )" + to_string(img->get_height()) + R"(, "tiles": [)";
+            for (size_t i = 0; i < updates.size(); i++) {
+                const Region& r = updates[i].region;
+                json_response += string(i ? ", " : "") + R"({"x": )" + to_string(r.x_begin) + R"(, "y": )" + to_string(r.y_begin)
+                    + R"(, "width": )" + to_string(r.x_end - r.x_begin + 1) + R"(, "height": )" + to_string(r.y_end - r.y_begin + 1)
+                    + R"(, "png": ")" + base64_encode(updates[i].bytes) + R"("})";
+            }
+            json_response += "]}";
+
+            res.status = 200;
+            res.set_content(json_response, "application/json");
+        }catch(exception& e){
+            // Se faltou parametro, avisa
+            cout << "Error: " << e.what() << endl;
+            res.status = 400;
+            string json_response = R"({"error": "bad request!"})";
+            res.set_content(json_response, "application/json");
+        }
+    });
+
+    /*
+        * Endpoint de eventos (Server-Sent Events) do progresso de um job, no lugar de consultas de tempos em tempos.
+        * A conexão fica aberta e o servidor envia os eventos assim que acontecem, até as duas saídas terminarem
+        * (ou o job ser cancelado). Depois do evento "ready" de uma saída, o cliente busca a imagem dela uma única vez.
+        *
+        * @params:
+            - jobId: número do job, retornado por /process (inteiro)
+            - jobToken: token do job, retornado por /process junto com o número; sem o token certo, a resposta é 404 (string)
+        *
+        * @returns (eventos, cada um com um JSON em `data`):
+            - region: bloco concluído, com a saída ("single" ou "multi"), a thread que o processou e a posição e dimensões dele
+            - progress: porcentagem de blocos concluídos de uma saída e o tempo decorrido em milissegundos
+            - ready: saída concluída, com a duração do processamento em milissegundos
+            - cancelled: o job foi cancelado (ex.: substituído por outro); a conexão é encerrada
+        *
+        * Com SERVER_MAX_HELD_CONNECTIONS conexões seguradas (eventos e consultas longas), a resposta é 503: o cliente deve acompanhar o job pelas consultas longas
+        * (`wait` em /getSingleThreadImage e /getMultiThreadImage), que também não esperam enquanto não houver conexão livre:
+        * assim as threads das outras requisições nunca ficam ocupadas.
+    */
+    server.Get("/events", [&jobs, &held_connections](const httplib::Request& req, httplib::Response& res) {
+        shared_ptr<Image> img;
+        try{
+            img = jobs.get(stoi(req.get_param_value("jobId")), req.get_param_value("jobToken"));
+        }catch(exception&){
+            res.status = 400;
+            res.set_content(R"({"error": "bad request!"})", "application/json");
+            return;
+        }
+        if (!img) {
+            res.status = 404;
+            res.set_content(R"({"error": "job not found"})", "application/json");
+            return;
+        }
+
+        // Reserva uma das conexões seguradas; a reserva é devolvida quando a conexão termina
+        if (held_connections.fetch_add(1) >= SERVER_MAX_HELD_CONNECTIONS) {
+            held_connections.fetch_sub(1);
+            res.status = 503;
+            res.set_content(R"({"error": "too many event streams"})", "application/json");
+            return;
+        }
+
+        // Estado da conexão: o último número de sequência enviado e se o evento "ready" já foi enviado, por saída
+        struct StreamState {
+            uint64_t sequence[2] = {0, 0};
+            bool ready[2] = {false, false};
+        };
+        auto state = make_shared<StreamState>();
+
+        res.set_header("Cache-Control", "no-cache");
+        res.set_chunked_content_provider("text/event-stream", [img, state](size_t, httplib::DataSink& sink) {
+            const char* names[] = {"single", "multi"};
+            shared_ptr<ProgressSignal> signal = img->get_progress_signal();
+
+            // Lê a versão antes de conferir o estado, para não perder uma mudança que aconteça no meio
+            uint64_t seen = signal->current();
+            string events;
+
+            for (int output = 0; output < 2; output++) {
+                if (state->ready[output]) continue;
+                bool multi = output == 1;
+
+                // Confere se terminou antes de pegar os blocos: se terminou, nenhum bloco fica de fora
+                bool done = multi ? img->get_multi_thread_done() : img->get_single_thread_done();
+                uint64_t sequence;
+                int total;
+                vector<TileCompletion> completions = img->get_tile_completions(multi, state->sequence[output], sequence, total);
+
+                for (const TileCompletion& tile : completions) {
+                    const Region& r = tile.region;
+                    events += string("event: region\ndata: ") + R"({"output": ")" + names[output] + R"(", "worker": )" + to_string(tile.worker)
+                        + R"(, "x": )" + to_string(r.x_begin) + R"(, "y": )" + to_string(r.y_begin)
+                        + R"(, "width": )" + to_string(r.x_end - r.x_begin + 1) + R"(, "height": )" + to_string(r.y_end - r.y_begin + 1) + "}\n\n";
+                }
+                if (!completions.empty() && total > 0) {
+                    events += string("event: progress\ndata: ") + R"({"output": ")" + names[output] + R"(", "percent": )"
+                        + to_string(100.0 * sequence / total) + R"(, "duration": )"
+                        + to_string(multi ? img->get_multi_thread_duration(false) : img->get_single_thread_duration(false)) + "}\n\n";
+                }
+                state->sequence[output] = sequence;
+
+                if (done) {
+                    events += string("event: ready\ndata: ") + R"({"output": ")" + names[output] + R"(", "duration": )"
+                        + to_string(multi ? img->get_multi_thread_duration(true) : img->get_single_thread_duration(true)) + "}\n\n";
+                    state->ready[output] = true;
+                }
+            }
+
+            bool cancelled = !(state->ready[0] && state->ready[1]) && img->is_cancelled();
+            if (cancelled) events += "event: cancelled\ndata: {}\n\n";
+
+            // Nada mudou: espera a próxima mudança e manda só um comentário, que mantém a conexão viva e detecta se o cliente saiu
+            if (events.empty()) {
+                if (signal->wait_for(seen, chrono::milliseconds(1000))) return true;
+                events = ": keep-alive\n\n";
+            }
+
+            if (!sink.write(events.data(), events.size())) return false;
+            if (cancelled || (state->ready[0] && state->ready[1])) sink.done();
+            return true;
+        }, [&held_connections](bool) { held_connections.fetch_sub(1); });
+    });
+
     /*
         * Endpoint para obter as opções de threads para o processamento de imagens via multi-threading.
         * 
         * @returns:
-            - maxThreads: número máximo de threads - 2, que é o número de threads disponíveis no sistema menos 2 (cabeçalho)
-            * Pois as outras duas threads são utilizadas para o processamento da imagem em single-threading e para a execução contínua do backend.
+            - maxThreads: número de CPUs que o processo pode usar (máscara de afinidade e cota de CPU do cgroup), que é o tamanho normal do pool de threads
     */
     server.Get("/getThreadsOptions", [](const httplib::Request& req, httplib::Response& res) {
         try{
             res.status = 200;
-            int thread_max = thread::hardware_concurrency() - 2;
+            int thread_max = effective_cpu_count();
             string json_response = R"({"maxThreads": )" + to_string(thread_max) + R"(})";
             res.set_content(json_response, "application/json");
         }catch(exception& e){
@@ -266,6 +731,29 @@ int main(){
         }
     });
 
+    /*
+        * Endpoint para obter as métricas do escalonador do pool de threads.
+        *
+        * @returns:
+            - classes: para cada classe de prioridade (interactive, normal, batch), a quantidade de tarefas já iniciadas
+              e o atraso de fila delas (tempo entre a tarefa ser adicionada e começar a rodar) médio e máximo, em milissegundos (JSON)
+    */
+    server.Get("/getSchedulerMetrics", [&jobs](const httplib::Request& req, httplib::Response& res) {
+        const char* names[] = {"interactive", "normal", "batch"};
+        shared_ptr<ThreadPool> pool = jobs.get_thread_pool();
+
+        string json_response = R"({"classes": [)";
+        for (int i = 0; i < THREADPOOL_PRIORITY_CLASSES; i++) {
+            QueueDelayStats stats = pool->queue_delay((TaskPriority) i);
+            json_response += string(i ? ", " : "") + R"({"priority": ")" + names[i] + R"(", "tasks": )" + to_string(stats.tasks)
+                + R"(, "meanDelayMs": )" + to_string(stats.mean_ms) + R"(, "maxDelayMs": )" + to_string(stats.max_ms) + "}";
+        }
+        json_response += "]}";
+
+        res.status = 200;
+        res.set_content(json_response, "application/json");
+    });
+
     /*
         * Endpoint para obter as opções de filtros disponíveis para o processamento de imagens.
         * 
@@ -280,19 +768,11 @@ int main(){
 
             // Retorna um json com o status_code e a mensagem de erro ou as opcoes possiveis
             res.status = 200;
-            string json_response = R"({"options": [
-                "negative", 
-                "thresholding",
-                "blur", 
-                "sharpen", 
-                "grayscale", 
-                "median", 
-                "gaussian", 
-                "laplacian90 sharpen",
-                "laplacian45 sharpen",
-                "laplacian90 border",
-                "laplacian45 border"
-            ]})";
+            string json_response = R"({"options": [)";
+            for (size_t i = 0; i < filter_names().size(); i++) {
+                json_response += (i ? ", " : "") + ("\"" + filter_names()[i] + "\"");
+            }
+            json_response += "]}";
             res.set_content(json_response, "application/json");
         }catch(exception& e){
             cout << "Error: " << e.what() << endl;
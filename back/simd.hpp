@@ -0,0 +1,455 @@
+#ifndef _SIMD_HPP_
+#define _SIMD_HPP_
+
+#include <cstdint>
+#include <opencv2/opencv.hpp>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+using namespace std;
+using namespace cv;
+
+/*
+    * Kernels vetorizados das operações pontuais (negativo, limiarização e escala de cinza).
+    *
+    * Cada kernel processa um trecho contínuo de uma linha da imagem (`n` pixels a partir de `src` e `dst`).
+    * As versões AVX2 e SSSE3 são compiladas com o atributo `target` do GCC, então o binário não exige
+    * nenhuma flag de compilação extra: o conjunto de instruções é escolhido uma vez, em tempo de execução,
+    * consultando o cpuid. Se a CPU não tiver suporte (ou não for x86), são usadas as versões escalares.
+    *
+    * Todas as versões produzem exatamente o mesmo resultado.
+*/
+
+// Conjuntos de instruções suportados pelos kernels
+enum class SimdLevel {
+    SCALAR, SSSE3, AVX2
+};
+
+// Pesos inteiros da escala de cinza (0.114 B + 0.587 G + 0.299 R), em milésimos
+#define GRAY_WEIGHT_B 114
+#define GRAY_WEIGHT_G 587
+#define GRAY_WEIGHT_R 299
+
+// VERSÕES ESCALARES //////////////////////////////////
+
+// Inverte cada byte (255 - valor). Serve para tons de cinza e BGR, já que todos os canais são invertidos
+inline void invert_bytes_scalar(const uchar* src, uchar* dst, int n) {
+    for (int i = 0; i < n; i++) dst[i] = 255 - src[i];
+}
+
+// Negativo HSV: gira o H em 90 (180 graus no HSV do OpenCV) e inverte S e V
+inline void negative_hsv_scalar(const uchar* src, uchar* dst, int n) {
+    for (int i = 0; i < n; i++, src += 3, dst += 3) {
+        dst[0] = (src[0] + 90) % 180; // H
+        dst[1] = 255 - src[1];        // S
+        dst[2] = 255 - src[2];        // V
+    }
+}
+
+// Limiarização de um canal: abaixo do limiar vira preto, senão branco
+inline void threshold_gray_scalar(const uchar* src, uchar* dst, int n, int threshold) {
+    for (int i = 0; i < n; i++) dst[i] = (src[i] < threshold) ? 0 : 255;
+}
+
+// Limiarização BGR pela média dos canais: média < limiar  <=>  soma < 3 * limiar
+inline void threshold_bgr_scalar(const uchar* src, uchar* dst, int n, int threshold) {
+    for (int i = 0; i < n; i++, src += 3, dst += 3) {
+        uchar value = (src[0] + src[1] + src[2] < 3 * threshold) ? 0 : 255;
+        dst[0] = dst[1] = dst[2] = value;
+    }
+}
+
+// Limiarização HSV: altera apenas o canal V, sem mexer em H e S da saída
+inline void threshold_hsv_scalar(const uchar* src, uchar* dst, int n, int threshold) {
+    for (int i = 0; i < n; i++) dst[3 * i + 2] = (src[3 * i + 2] < threshold) ? 0 : 255;
+}
+
+// Escala de cinza BGR com pesos inteiros, arredondando para o inteiro mais próximo
+inline void grayscale_bgr_scalar(const uchar* src, uchar* dst, int n) {
+    for (int i = 0; i < n; i++, src += 3, dst += 3) {
+        uchar value = (GRAY_WEIGHT_B * src[0] + GRAY_WEIGHT_G * src[1] + GRAY_WEIGHT_R * src[2] + 500) / 1000;
+        dst[0] = dst[1] = dst[2] = value;
+    }
+}
+
+// Escala de cinza HSV: zera a saturação e mantém H e V
+inline void grayscale_hsv_scalar(const uchar* src, uchar* dst, int n) {
+    for (int i = 0; i < n; i++, src += 3, dst += 3) {
+        dst[0] = src[0]; // H
+        dst[1] = 0;      // S
+        dst[2] = src[2]; // V
+    }
+}
+
+#ifdef SIMD_X86
+
+// MÁSCARAS //////////////////////////////////
+
+/*
+    * Máscaras de embaralhamento (pshufb) para separar e juntar os canais de 16 pixels BGR (48 bytes, 3 vetores).
+    * Calculadas uma única vez, a partir da posição de cada byte, ao invés de escritas à mão.
+*/
+struct ShuffleMasks3 {
+    // deinterleave[c][v]: leva o canal c dos pixels contidos no vetor de entrada v para sua posição (0..15)
+    uint8_t deinterleave[3][3][16];
+
+    // interleave[v]: repete o valor do pixel p nos 3 canais do vetor de saída v
+    uint8_t interleave[3][16];
+
+    // channel16[c][v] / channel32[c][v]: 0xFF nos bytes do canal c de um bloco de 48 / 96 bytes
+    uint8_t channel16[3][3][16];
+    uint8_t channel32[3][3][32];
+
+    ShuffleMasks3() {
+        for (int c = 0; c < 3; c++) {
+            for (int v = 0; v < 3; v++) {
+                for (int p = 0; p < 16; p++) {
+                    int byte = 3 * p + c;
+                    deinterleave[c][v][p] = (byte / 16 == v) ? (uint8_t) (byte % 16) : 0x80;
+                }
+                for (int j = 0; j < 16; j++) channel16[c][v][j] = ((16 * v + j) % 3 == c) ? 0xFF : 0x00;
+                for (int j = 0; j < 32; j++) channel32[c][v][j] = ((32 * v + j) % 3 == c) ? 0xFF : 0x00;
+            }
+        }
+        for (int v = 0; v < 3; v++) {
+            for (int j = 0; j < 16; j++) interleave[v][j] = (uint8_t) ((16 * v + j) / 3);
+        }
+    }
+
+    static const ShuffleMasks3& instance() {
+        static const ShuffleMasks3 masks;
+        return masks;
+    }
+};
+
+#define LOAD128(p) _mm_loadu_si128((const __m128i*) (p))
+#define LOAD256(p) _mm256_loadu_si256((const __m256i*) (p))
+
+// VERSÕES SSE2 / SSSE3 (16 pixels por iteração) //////////////////////////////////
+
+__attribute__((target("ssse3")))
+inline void invert_bytes_ssse3(const uchar* src, uchar* dst, int n) {
+    const __m128i ones = _mm_set1_epi8((char) 0xFF);
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*) (src + i));
+        _mm_storeu_si128((__m128i*) (dst + i), _mm_xor_si128(v, ones));
+    }
+    invert_bytes_scalar(src + i, dst + i, n - i);
+}
+
+__attribute__((target("ssse3")))
+inline void threshold_gray_ssse3(const uchar* src, uchar* dst, int n, int threshold) {
+    int i = 0;
+    if (threshold <= 255) {
+        const __m128i limit = _mm_set1_epi8((char) max(threshold, 0));
+        for (; i + 16 <= n; i += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i*) (src + i));
+            // v >= limiar  <=>  max(v, limiar) == v
+            __m128i ge = _mm_cmpeq_epi8(_mm_max_epu8(v, limit), v);
+            _mm_storeu_si128((__m128i*) (dst + i), ge);
+        }
+    }
+    threshold_gray_scalar(src + i, dst + i, n - i, threshold);
+}
+
+// Separa 16 pixels BGR (48 bytes) nos vetores b, g e r
+__attribute__((target("ssse3")))
+inline void deinterleave_bgr_ssse3(const uchar* src, __m128i& b, __m128i& g, __m128i& r) {
+    const ShuffleMasks3& m = ShuffleMasks3::instance();
+    __m128i v0 = _mm_loadu_si128((const __m128i*) (src));
+    __m128i v1 = _mm_loadu_si128((const __m128i*) (src + 16));
+    __m128i v2 = _mm_loadu_si128((const __m128i*) (src + 32));
+    __m128i* channels[3] = {&b, &g, &r};
+    for (int c = 0; c < 3; c++) {
+        *channels[c] = _mm_or_si128(_mm_or_si128(
+            _mm_shuffle_epi8(v0, LOAD128(m.deinterleave[c][0])),
+            _mm_shuffle_epi8(v1, LOAD128(m.deinterleave[c][1]))),
+            _mm_shuffle_epi8(v2, LOAD128(m.deinterleave[c][2])));
+    }
+}
+
+// Escreve o valor de cada um dos 16 pixels nos 3 canais (48 bytes)
+__attribute__((target("ssse3")))
+inline void store_gray_as_bgr_ssse3(uchar* dst, __m128i value) {
+    const ShuffleMasks3& m = ShuffleMasks3::instance();
+    _mm_storeu_si128((__m128i*) (dst), _mm_shuffle_epi8(value, LOAD128(m.interleave[0])));
+    _mm_storeu_si128((__m128i*) (dst + 16), _mm_shuffle_epi8(value, LOAD128(m.interleave[1])));
+    _mm_storeu_si128((__m128i*) (dst + 32), _mm_shuffle_epi8(value, LOAD128(m.interleave[2])));
+}
+
+__attribute__((target("ssse3")))
+inline void negative_hsv_ssse3(const uchar* src, uchar* dst, int n) {
+    const ShuffleMasks3& m = ShuffleMasks3::instance();
+    const __m128i ones = _mm_set1_epi8((char) 0xFF);
+    const __m128i ninety = _mm_set1_epi8(90);
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        for (int v = 0; v < 3; v++) {
+            __m128i x = _mm_loadu_si128((const __m128i*) (src + 3 * i + 16 * v));
+            // H: (h + 90) % 180  ==  h >= 90 ? h - 90 : h + 90
+            __m128i ge = _mm_cmpeq_epi8(_mm_max_epu8(x, ninety), x);
+            __m128i hue = _mm_or_si128(_mm_and_si128(ge, _mm_sub_epi8(x, ninety)), _mm_andnot_si128(ge, _mm_add_epi8(x, ninety)));
+            __m128i is_hue = LOAD128(m.channel16[0][v]);
+            __m128i result = _mm_or_si128(_mm_and_si128(is_hue, hue), _mm_andnot_si128(is_hue, _mm_xor_si128(x, ones)));
+            _mm_storeu_si128((__m128i*) (dst + 3 * i + 16 * v), result);
+        }
+    }
+    negative_hsv_scalar(src + 3 * i, dst + 3 * i, n - i);
+}
+
+__attribute__((target("ssse3")))
+inline void threshold_bgr_ssse3(const uchar* src, uchar* dst, int n, int threshold) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i limit = _mm_set1_epi16((short) (3 * threshold));
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i b, g, r;
+        deinterleave_bgr_ssse3(src + 3 * i, b, g, r);
+
+        // soma dos 3 canais em 16 bits (no máximo 765)
+        __m128i sum_lo = _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi8(b, zero), _mm_unpacklo_epi8(g, zero)), _mm_unpacklo_epi8(r, zero));
+        __m128i sum_hi = _mm_add_epi16(_mm_add_epi16(_mm_unpackhi_epi8(b, zero), _mm_unpackhi_epi8(g, zero)), _mm_unpackhi_epi8(r, zero));
+
+        // 0xFF onde soma >= 3 * limiar (branco), 0 caso contrário (preto)
+        __m128i white_lo = _mm_xor_si128(_mm_cmplt_epi16(sum_lo, limit), _mm_set1_epi16(-1));
+        __m128i white_hi = _mm_xor_si128(_mm_cmplt_epi16(sum_hi, limit), _mm_set1_epi16(-1));
+
+        store_gray_as_bgr_ssse3(dst + 3 * i, _mm_packs_epi16(white_lo, white_hi));
+    }
+    threshold_bgr_scalar(src + 3 * i, dst + 3 * i, n - i, threshold);
+}
+
+__attribute__((target("ssse3")))
+inline void threshold_hsv_ssse3(const uchar* src, uchar* dst, int n, int threshold) {
+    const ShuffleMasks3& m = ShuffleMasks3::instance();
+    int i = 0;
+    if (threshold <= 255) {
+        const __m128i limit = _mm_set1_epi8((char) max(threshold, 0));
+        for (; i + 16 <= n; i += 16) {
+            for (int v = 0; v < 3; v++) {
+                __m128i x = _mm_loadu_si128((const __m128i*) (src + 3 * i + 16 * v));
+                __m128i out = _mm_loadu_si128((const __m128i*) (dst + 3 * i + 16 * v));
+                __m128i ge = _mm_cmpeq_epi8(_mm_max_epu8(x, limit), x);
+                // só os bytes do canal V são substituídos
+                __m128i is_value = LOAD128(m.channel16[2][v]);
+                __m128i result = _mm_or_si128(_mm_and_si128(is_value, ge), _mm_andnot_si128(is_value, out));
+                _mm_storeu_si128((__m128i*) (dst + 3 * i + 16 * v), result);
+            }
+        }
+    }
+    threshold_hsv_scalar(src + 3 * i, dst + 3 * i, n - i, threshold);
+}
+
+// (114 b + 587 g + 299 r + 500) / 1000 para 4 pixels (metade baixa ou alta dos vetores de 16 bits)
+// Usa pares (b, g) e (r, 1) no madd, que multiplica e soma os pares em 32 bits
+__attribute__((target("ssse3")))
+inline __m128i weighted_gray_ssse3(__m128i b16, __m128i g16, __m128i r16, bool high) {
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i weights_bg = _mm_set_epi16(GRAY_WEIGHT_G, GRAY_WEIGHT_B, GRAY_WEIGHT_G, GRAY_WEIGHT_B, GRAY_WEIGHT_G, GRAY_WEIGHT_B, GRAY_WEIGHT_G, GRAY_WEIGHT_B);
+    const __m128i weights_r1 = _mm_set_epi16(500, GRAY_WEIGHT_R, 500, GRAY_WEIGHT_R, 500, GRAY_WEIGHT_R, 500, GRAY_WEIGHT_R);
+
+    __m128i bg = high ? _mm_unpackhi_epi16(b16, g16) : _mm_unpacklo_epi16(b16, g16);
+    __m128i r1 = high ? _mm_unpackhi_epi16(r16, one) : _mm_unpacklo_epi16(r16, one);
+    __m128i sum = _mm_add_epi32(_mm_madd_epi16(bg, weights_bg), _mm_madd_epi16(r1, weights_r1));
+
+    // a soma cabe em 24 bits e a divisão em float é arredondada corretamente, então truncar dá a divisão inteira exata
+    return _mm_cvttps_epi32(_mm_div_ps(_mm_cvtepi32_ps(sum), _mm_set1_ps(1000.0f)));
+}
+
+__attribute__((target("ssse3")))
+inline void grayscale_bgr_ssse3(const uchar* src, uchar* dst, int n) {
+    const __m128i zero = _mm_setzero_si128();
+
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i b, g, r;
+        deinterleave_bgr_ssse3(src + 3 * i, b, g, r);
+
+        __m128i b_lo = _mm_unpacklo_epi8(b, zero), b_hi = _mm_unpackhi_epi8(b, zero);
+        __m128i g_lo = _mm_unpacklo_epi8(g, zero), g_hi = _mm_unpackhi_epi8(g, zero);
+        __m128i r_lo = _mm_unpacklo_epi8(r, zero), r_hi = _mm_unpackhi_epi8(r, zero);
+
+        __m128i gray_lo = _mm_packs_epi32(weighted_gray_ssse3(b_lo, g_lo, r_lo, false), weighted_gray_ssse3(b_lo, g_lo, r_lo, true));
+        __m128i gray_hi = _mm_packs_epi32(weighted_gray_ssse3(b_hi, g_hi, r_hi, false), weighted_gray_ssse3(b_hi, g_hi, r_hi, true));
+
+        store_gray_as_bgr_ssse3(dst + 3 * i, _mm_packus_epi16(gray_lo, gray_hi));
+    }
+    grayscale_bgr_scalar(src + 3 * i, dst + 3 * i, n - i);
+}
+
+__attribute__((target("ssse3")))
+inline void grayscale_hsv_ssse3(const uchar* src, uchar* dst, int n) {
+    const ShuffleMasks3& m = ShuffleMasks3::instance();
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        for (int v = 0; v < 3; v++) {
+            __m128i x = _mm_loadu_si128((const __m128i*) (src + 3 * i + 16 * v));
+            // zera os bytes do canal S
+            _mm_storeu_si128((__m128i*) (dst + 3 * i + 16 * v), _mm_andnot_si128(LOAD128(m.channel16[1][v]), x));
+        }
+    }
+    grayscale_hsv_scalar(src + 3 * i, dst + 3 * i, n - i);
+}
+
+// VERSÕES AVX2 (32 pixels por iteração em tons de cinza, 32 pixels / 96 bytes em HSV) //////////////////////////////////
+
+__attribute__((target("avx2")))
+inline void invert_bytes_avx2(const uchar* src, uchar* dst, int n) {
+    const __m256i ones = _mm256_set1_epi8((char) 0xFF);
+    int i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*) (src + i));
+        _mm256_storeu_si256((__m256i*) (dst + i), _mm256_xor_si256(v, ones));
+    }
+    invert_bytes_scalar(src + i, dst + i, n - i);
+}
+
+__attribute__((target("avx2")))
+inline void threshold_gray_avx2(const uchar* src, uchar* dst, int n, int threshold) {
+    int i = 0;
+    if (threshold <= 255) {
+        const __m256i limit = _mm256_set1_epi8((char) max(threshold, 0));
+        for (; i + 32 <= n; i += 32) {
+            __m256i v = _mm256_loadu_si256((const __m256i*) (src + i));
+            __m256i ge = _mm256_cmpeq_epi8(_mm256_max_epu8(v, limit), v);
+            _mm256_storeu_si256((__m256i*) (dst + i), ge);
+        }
+    }
+    threshold_gray_scalar(src + i, dst + i, n - i, threshold);
+}
+
+__attribute__((target("avx2")))
+inline void negative_hsv_avx2(const uchar* src, uchar* dst, int n) {
+    const ShuffleMasks3& m = ShuffleMasks3::instance();
+    const __m256i ones = _mm256_set1_epi8((char) 0xFF);
+    const __m256i ninety = _mm256_set1_epi8(90);
+    int i = 0;
+    for (; i + 32 <= n; i += 32) {
+        for (int v = 0; v < 3; v++) {
+            __m256i x = _mm256_loadu_si256((const __m256i*) (src + 3 * i + 32 * v));
+            __m256i ge = _mm256_cmpeq_epi8(_mm256_max_epu8(x, ninety), x);
+            __m256i hue = _mm256_blendv_epi8(_mm256_add_epi8(x, ninety), _mm256_sub_epi8(x, ninety), ge);
+            __m256i result = _mm256_blendv_epi8(_mm256_xor_si256(x, ones), hue, LOAD256(m.channel32[0][v]));
+            _mm256_storeu_si256((__m256i*) (dst + 3 * i + 32 * v), result);
+        }
+    }
+    negative_hsv_scalar(src + 3 * i, dst + 3 * i, n - i);
+}
+
+__attribute__((target("avx2")))
+inline void threshold_hsv_avx2(const uchar* src, uchar* dst, int n, int threshold) {
+    const ShuffleMasks3& m = ShuffleMasks3::instance();
+    int i = 0;
+    if (threshold <= 255) {
+        const __m256i limit = _mm256_set1_epi8((char) max(threshold, 0));
+        for (; i + 32 <= n; i += 32) {
+            for (int v = 0; v < 3; v++) {
+                __m256i x = _mm256_loadu_si256((const __m256i*) (src + 3 * i + 32 * v));
+                __m256i out = _mm256_loadu_si256((const __m256i*) (dst + 3 * i + 32 * v));
+                __m256i ge = _mm256_cmpeq_epi8(_mm256_max_epu8(x, limit), x);
+                __m256i result = _mm256_blendv_epi8(out, ge, LOAD256(m.channel32[2][v]));
+                _mm256_storeu_si256((__m256i*) (dst + 3 * i + 32 * v), result);
+            }
+        }
+    }
+    threshold_hsv_scalar(src + 3 * i, dst + 3 * i, n - i, threshold);
+}
+
+__attribute__((target("avx2")))
+inline void grayscale_hsv_avx2(const uchar* src, uchar* dst, int n) {
+    const ShuffleMasks3& m = ShuffleMasks3::instance();
+    int i = 0;
+    for (; i + 32 <= n; i += 32) {
+        for (int v = 0; v < 3; v++) {
+            __m256i x = _mm256_loadu_si256((const __m256i*) (src + 3 * i + 32 * v));
+            _mm256_storeu_si256((__m256i*) (dst + 3 * i + 32 * v), _mm256_andnot_si256(LOAD256(m.channel32[1][v]), x));
+        }
+    }
+    grayscale_hsv_scalar(src + 3 * i, dst + 3 * i, n - i);
+}
+
+#undef LOAD128
+#undef LOAD256
+
+#endif // SIMD_X86
+
+// DESPACHO //////////////////////////////////
+
+/*
+    * Tabela com os kernels escolhidos para a CPU atual.
+    * `invert` recebe a quantidade de bytes; os demais recebem a quantidade de pixels.
+*/
+struct PointKernels {
+    SimdLevel level;
+    void (*invert)(const uchar*, uchar*, int);
+    void (*negative_hsv)(const uchar*, uchar*, int);
+    void (*threshold_gray)(const uchar*, uchar*, int, int);
+    void (*threshold_bgr)(const uchar*, uchar*, int, int);
+    void (*threshold_hsv)(const uchar*, uchar*, int, int);
+    void (*grayscale_bgr)(const uchar*, uchar*, int);
+    void (*grayscale_hsv)(const uchar*, uchar*, int);
+};
+
+/*
+    * Detecta, via cpuid, o melhor conjunto de instruções disponível.
+    * @returns: nível de SIMD suportado pela CPU
+*/
+inline SimdLevel detect_simd_level() {
+#ifdef SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+    if (__builtin_cpu_supports("ssse3")) return SimdLevel::SSSE3;
+#endif
+    return SimdLevel::SCALAR;
+}
+
+/*
+    * Monta a tabela de kernels de um nível de SIMD.
+    * As operações em 3 canais intercalados (BGR) usam as versões SSSE3 também no nível AVX2,
+    * já que o embaralhamento (pshufb) do AVX2 não cruza as metades de 128 bits do registrador.
+    * @param level Nível de SIMD desejado
+    * @returns: tabela de kernels
+*/
+inline PointKernels make_point_kernels(SimdLevel level) {
+    PointKernels k = {SimdLevel::SCALAR, invert_bytes_scalar, negative_hsv_scalar, threshold_gray_scalar,
+                      threshold_bgr_scalar, threshold_hsv_scalar, grayscale_bgr_scalar, grayscale_hsv_scalar};
+#ifdef SIMD_X86
+    if (level == SimdLevel::SSSE3 || level == SimdLevel::AVX2) {
+        k = {SimdLevel::SSSE3, invert_bytes_ssse3, negative_hsv_ssse3, threshold_gray_ssse3,
+             threshold_bgr_ssse3, threshold_hsv_ssse3, grayscale_bgr_ssse3, grayscale_hsv_ssse3};
+    }
+    if (level == SimdLevel::AVX2) {
+        k.level = SimdLevel::AVX2;
+        k.invert = invert_bytes_avx2;
+        k.negative_hsv = negative_hsv_avx2;
+        k.threshold_gray = threshold_gray_avx2;
+        k.threshold_hsv = threshold_hsv_avx2;
+        k.grayscale_hsv = grayscale_hsv_avx2;
+    }
+#endif
+    return k;
+}
+
+/*
+    * Retorna os kernels da CPU atual, detectados uma única vez (na primeira chamada, feita pelo construtor de `Image`).
+    * @returns: referência para a tabela de kernels
+*/
+inline const PointKernels& point_kernels() {
+    static const PointKernels kernels = make_point_kernels(detect_simd_level());
+    return kernels;
+}
+
+// Nome do nível de SIMD, para log
+inline const char* simd_level_name(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::AVX2: return "AVX2";
+        case SimdLevel::SSSE3: return "SSSE3";
+        default: return "escalar";
+    }
+}
+
+#endif // _SIMD_HPP_
@@ -0,0 +1,154 @@
+#ifndef _STENCIL_HPP_
+#define _STENCIL_HPP_
+
+#include <utility>
+#include <cmath>
+#include <algorithm>
+#include <opencv2/opencv.hpp>
+#include "region.hpp"
+#include "padded_image.hpp"
+
+using namespace std;
+using namespace cv;
+
+/*
+    * Motor de stencils 3x3 especializados em tempo de compilação, usado pela família de filtros laplacianos.
+    *
+    * Os pesos da máscara, a quantidade de canais e o modo de saída são parâmetros de template. Assim cada
+    * stencil vira código inteiro em linha reta: os pesos são constantes, os vizinhos com peso zero nem são
+    * lidos e pesos 1 e -1 viram somas e subtrações. A entrada vem da imagem com borda de zeros, então não
+    * há testes de limite, e cada iteração do laço calcula vários pixels de saída.
+*/
+
+// Máscara 3x3 com pesos inteiros conhecidos em tempo de compilação (linha a linha, de cima para baixo)
+template <int... W>
+struct Mask3x3 {
+    static_assert(sizeof...(W) == 9, "a máscara deve ter 9 pesos");
+    static constexpr int weights[9] = {W...};
+};
+
+// Máscara de laplaciano sem as diagonais (90°)
+using Laplacian90Mask = Mask3x3<0,  1, 0,
+                                1, -4, 1,
+                                0,  1, 0>;
+
+// Máscara de laplaciano com as diagonais (45°)
+using Laplacian45Mask = Mask3x3<1,  1, 1,
+                                1, -8, 1,
+                                1,  1, 1>;
+
+// O que fazer com a resposta da máscara
+enum class StencilMode {
+    BORDER,     // detecção de bordas: saída = resposta da máscara
+    SHARPEN     // nitidez: saída = entrada - k * resposta da máscara
+};
+
+// Contribuição de um vizinho com peso W: some do código quando W == 0
+template <int W>
+inline int stencil_tap(const uchar* p) {
+    if constexpr (W == 0) return 0;
+    else if constexpr (W == 1) return *p;
+    else if constexpr (W == -1) return -*p;
+    else return W * *p;
+}
+
+// Resposta da máscara no pixel apontado por `mid` (linha do meio), com CN bytes entre pixels vizinhos
+template <typename Mask, int CN, size_t... I>
+inline int stencil_response(const uchar* top, const uchar* mid, const uchar* bottom, index_sequence<I...>) {
+    const uchar* rows[3] = {top, mid, bottom};
+    return (stencil_tap<Mask::weights[I]>(rows[I / 3] + ((int) (I % 3) - 1) * CN) + ...);
+}
+
+// Converte a resposta da máscara no valor de saída do pixel
+template <StencilMode MODE>
+inline uchar stencil_output(uchar input, int response, float k) {
+    if constexpr (MODE == StencilMode::BORDER)
+        return (uchar) std::clamp(response, 0, 255);
+    else
+        return (uchar) std::clamp((double) round(input - k * response), 0.0, 255.0);
+}
+
+// Quantidade de pixels de saída calculados por iteração do laço
+#define STENCIL_BLOCK 4
+
+/*
+    * Aplica o stencil 3x3 na região da imagem.
+    *
+    * @tparam Mask Máscara 3x3 (ex.: Laplacian90Mask)
+    * @tparam CN Quantidade de canais da imagem (1 ou 3)
+    * @tparam ONLY_V Se verdadeiro (HSV), aplica apenas no canal V e copia H e S da entrada
+    * @tparam MODE Modo de saída (detecção de bordas ou nitidez)
+    * @param src Imagem de entrada com borda de zeros de pelo menos 1 pixel
+    * @param dst Imagem de saída, do mesmo tamanho e tipo da imagem original
+    * @param region Região da imagem a ser processada
+    * @param k Peso da resposta da máscara no modo de nitidez
+    * @returns: void
+*/
+template <typename Mask, int CN, bool ONLY_V, StencilMode MODE>
+inline void apply_stencil3x3(const PaddedImage& src, Mat& dst, Region region, float k) {
+    constexpr auto taps = make_index_sequence<9>();
+
+    // canais filtrados em cada pixel
+    constexpr int first_channel = ONLY_V ? 2 : 0;
+    constexpr int nc = ONLY_V ? 1 : CN;
+
+    for (int y = region.y_begin; y <= region.y_end; y++) {
+        const uchar* top = src.row(y - 1);
+        const uchar* mid = src.row(y);
+        const uchar* bottom = src.row(y + 1);
+        uchar* output_row = dst.ptr<uchar>(y);
+
+        int x = region.x_begin;
+
+        // Bloco de STENCIL_BLOCK pixels por iteração, em código linear
+        for (; x + STENCIL_BLOCK - 1 <= region.x_end; x += STENCIL_BLOCK) {
+            for (int b = 0; b < STENCIL_BLOCK; b++) {
+                const int offset = (x + b) * CN;
+                if constexpr (ONLY_V) {
+                    output_row[offset + 0] = mid[offset + 0]; // H (mantém o mesmo valor)
+                    output_row[offset + 1] = mid[offset + 1]; // S (mantém o mesmo valor)
+                }
+                for (int c = first_channel; c < first_channel + nc; c++) {
+                    int response = stencil_response<Mask, CN>(top + offset + c, mid + offset + c, bottom + offset + c, taps);
+                    output_row[offset + c] = stencil_output<MODE>(mid[offset + c], response, k);
+                }
+            }
+        }
+
+        // Pixels que sobraram no fim da linha
+        for (; x <= region.x_end; x++) {
+            const int offset = x * CN;
+            if constexpr (ONLY_V) {
+                output_row[offset + 0] = mid[offset + 0];
+                output_row[offset + 1] = mid[offset + 1];
+            }
+            for (int c = first_channel; c < first_channel + nc; c++) {
+                int response = stencil_response<Mask, CN>(top + offset + c, mid + offset + c, bottom + offset + c, taps);
+                output_row[offset + c] = stencil_output<MODE>(mid[offset + c], response, k);
+            }
+        }
+    }
+}
+
+#undef STENCIL_BLOCK
+
+/*
+    * Escolhe a instância do stencil de acordo com a quantidade de canais da imagem.
+    * @param src Imagem de entrada com borda de zeros de pelo menos 1 pixel
+    * @param dst Imagem de saída
+    * @param region Região da imagem a ser processada
+    * @param only_v Se verdadeiro (HSV), aplica apenas no canal V
+    * @param k Peso da resposta da máscara no modo de nitidez
+    * @returns: void
+*/
+template <typename Mask, StencilMode MODE>
+inline void stencil3x3(const PaddedImage& src, Mat& dst, Region region, bool only_v, float k = 0.0f) {
+    if (src.cn == 1)
+        apply_stencil3x3<Mask, 1, false, MODE>(src, dst, region, k);
+    else if (only_v)
+        apply_stencil3x3<Mask, 3, true, MODE>(src, dst, region, k);
+    else
+        apply_stencil3x3<Mask, 3, false, MODE>(src, dst, region, k);
+}
+
+#endif // _STENCIL_HPP_
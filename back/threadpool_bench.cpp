@@ -0,0 +1,235 @@
+// Benchmark de despacho de tarefas: pool com roubo de tarefas (ThreadPool.hpp) x pool anterior (fila única com mutex)
+// Mede a vazão (tarefas por segundo) e a latência entre adicionar uma tarefa e ela começar a executar
+// make bench_threadpool && ./bench_threadpool [threads] [tarefas]
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <queue>
+#include <string>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <functional>
+#include <pthread.h>
+#include "ThreadPool.hpp"
+
+using namespace std;
+using namespace std::chrono;
+
+/*
+    * Pool anterior, mantido aqui apenas para comparação:
+    * todas as threads disputam uma única fila de tarefas protegida por um mutex.
+*/
+class LegacyThreadPool {
+    private:
+        bool stop = false;
+        vector<pthread_t> threads;
+        queue<function<void()>> tasks;
+        pthread_mutex_t mtx = PTHREAD_MUTEX_INITIALIZER;
+        pthread_cond_t cond_var = PTHREAD_COND_INITIALIZER;
+
+        static void* thread_function(void* arg) {
+            LegacyThreadPool* pool = static_cast<LegacyThreadPool*>(arg);
+            while (true) {
+                pthread_mutex_lock(&pool->mtx);
+                while (!pool->stop && pool->tasks.empty()) pthread_cond_wait(&pool->cond_var, &pool->mtx);
+                if (pool->stop && pool->tasks.empty()) {
+                    pthread_mutex_unlock(&pool->mtx);
+                    return nullptr;
+                }
+                function<void()> task = move(pool->tasks.front());
+                pool->tasks.pop();
+                pthread_mutex_unlock(&pool->mtx);
+                task();
+            }
+        }
+
+    public:
+        LegacyThreadPool(int num_threads) {
+            for (int i = 0; i < num_threads; i++) {
+                pthread_t thread;
+                pthread_create(&thread, nullptr, thread_function, this);
+                threads.push_back(thread);
+            }
+        }
+
+        ~LegacyThreadPool() {
+            pthread_mutex_lock(&mtx);
+            stop = true;
+            pthread_mutex_unlock(&mtx);
+            pthread_cond_broadcast(&cond_var);
+            for (auto& thread : threads) pthread_join(thread, nullptr);
+        }
+
+        void enqueue(function<void()> task) {
+            pthread_mutex_lock(&mtx);
+            tasks.push(move(task));
+            pthread_cond_signal(&cond_var);
+            pthread_mutex_unlock(&mtx);
+        }
+};
+
+// Trabalho de cada tarefa, simulando um tile pequeno (`work` iterações)
+static inline void busy_work(int work) {
+    volatile unsigned x = 0;
+    for (int i = 0; i < work; i++) x = x * 31 + i;
+}
+
+// Espera até que `done` chegue em `total`
+static void wait_for(const atomic<int>& done, int total) {
+    while (done.load(memory_order_acquire) < total) this_thread::yield();
+}
+
+/*
+    * Cenário 1: todas as tarefas são adicionadas de fora do pool (como o servidor faz hoje).
+    * @returns: milhões de tarefas por segundo
+*/
+template <typename Pool>
+double bench_external(Pool& pool, int tasks, int work) {
+    atomic<int> done(0);
+    auto start = steady_clock::now();
+    for (int i = 0; i < tasks; i++) {
+        pool.enqueue([&done, work] {
+            busy_work(work);
+            done.fetch_add(1, memory_order_release);
+        });
+    }
+    wait_for(done, tasks);
+    double seconds = duration<double>(steady_clock::now() - start).count();
+    return tasks / seconds / 1e6;
+}
+
+/*
+    * Cenário 2: poucas tarefas de fora, cada uma criando muitas tarefas filhas (como tiles criados dentro de um job).
+    * @returns: milhões de tarefas por segundo
+*/
+template <typename Pool>
+double bench_nested(Pool& pool, int threads, int tasks, int work) {
+    atomic<int> done(0);
+    int per_parent = tasks / threads;
+    int total = per_parent * threads;
+    auto start = steady_clock::now();
+    for (int p = 0; p < threads; p++) {
+        pool.enqueue([&pool, &done, per_parent, work] {
+            for (int i = 0; i < per_parent; i++) {
+                pool.enqueue([&done, work] {
+                    busy_work(work);
+                    done.fetch_add(1, memory_order_release);
+                });
+            }
+        });
+    }
+    wait_for(done, total);
+    double seconds = duration<double>(steady_clock::now() - start).count();
+    return total / seconds / 1e6;
+}
+
+/*
+    * Cenário 3: `producers` threads de fora do pool adicionam tarefas espaçadas (`gap_ns` entre elas),
+    * e cada tarefa anota quanto tempo passou entre ser adicionada e começar a executar.
+    * @returns: latências em nanossegundos, ordenadas
+*/
+template <typename Pool>
+vector<double> bench_latency(Pool& pool, int producers, int tasks, int gap_ns) {
+    int per_producer = max(1, tasks / producers);
+    int total = per_producer * producers;
+    vector<double> latencies(total);
+    atomic<int> done(0);
+
+    vector<thread> threads;
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&, p] {
+            for (int i = 0; i < per_producer; i++) {
+                auto enqueued = steady_clock::now();
+                double* slot = &latencies[p * per_producer + i];
+                pool.enqueue([slot, enqueued, &done] {
+                    *slot = duration<double, nano>(steady_clock::now() - enqueued).count();
+                    done.fetch_add(1, memory_order_release);
+                });
+
+                // Espaça as tarefas, para medir a latência e não a fila cheia
+                auto next = enqueued + nanoseconds(gap_ns);
+                while (steady_clock::now() < next) {}
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    wait_for(done, total);
+
+    sort(latencies.begin(), latencies.end());
+    return latencies;
+}
+
+// Percentil `q` (entre 0 e 1) de um vetor ordenado, em microssegundos
+static double percentile_us(const vector<double>& sorted, double q) {
+    size_t i = min(sorted.size() - 1, (size_t) (q * (sorted.size() - 1)));
+    return sorted[i] / 1000.0;
+}
+
+// Mediana de `runs` execuções
+template <typename Fn>
+double median_of_runs(int runs, Fn fn) {
+    vector<double> results;
+    for (int i = 0; i < runs; i++) results.push_back(fn());
+    sort(results.begin(), results.end());
+    return results[results.size() / 2];
+}
+
+int main(int argc, char** argv) {
+    int threads = argc > 1 ? stoi(argv[1]) : max(1u, thread::hardware_concurrency());
+    int tasks = argc > 2 ? stoi(argv[2]) : 200000;
+    const int runs = 5;
+
+    cout << "Threads: " << threads << ", tarefas por execução: " << tasks << ", mediana de " << runs << " execuções" << endl;
+    cout << left << setw(28) << "cenário" << setw(16) << "mutex (Mt/s)" << setw(16) << "stealing (Mt/s)" << endl;
+
+    for (int work : {0, 200, 2000}) {
+        double legacy_external, stealing_external, legacy_nested, stealing_nested;
+        {
+            LegacyThreadPool pool(threads);
+            legacy_external = median_of_runs(runs, [&] { return bench_external(pool, tasks, work); });
+            legacy_nested = median_of_runs(runs, [&] { return bench_nested(pool, threads, tasks, work); });
+        }
+        {
+            ThreadPool pool(threads);
+            stealing_external = median_of_runs(runs, [&] { return bench_external(pool, tasks, work); });
+            stealing_nested = median_of_runs(runs, [&] { return bench_nested(pool, threads, tasks, work); });
+        }
+
+        cout << fixed << setprecision(2);
+        cout << left << setw(28) << ("externo, trabalho " + to_string(work)) << setw(16) << legacy_external << setw(16) << stealing_external << endl;
+        cout << left << setw(28) << ("aninhado, trabalho " + to_string(work)) << setw(16) << legacy_nested << setw(16) << stealing_nested << endl;
+    }
+
+    // Latência entre adicionar e começar a executar, com 1, 4 e todos os núcleos produzindo
+    int cores = max(1u, thread::hardware_concurrency());
+    int latency_tasks = min(tasks, 50000);
+    const int gap_ns = 5000;
+
+    cout << endl << "Latência de início (us), " << latency_tasks << " tarefas, uma a cada " << gap_ns / 1000 << " us por produtor" << endl;
+    cout << left << setw(28) << "produtores / pool" << setw(12) << "p50" << setw(12) << "p99" << setw(12) << "p99.9" << endl;
+
+    for (int producers : {1, 4, cores}) {
+        vector<double> legacy_latency, stealing_latency;
+        {
+            LegacyThreadPool pool(threads);
+            legacy_latency = bench_latency(pool, producers, latency_tasks, gap_ns);
+        }
+        {
+            ThreadPool pool(threads);
+            stealing_latency = bench_latency(pool, producers, latency_tasks, gap_ns);
+        }
+
+        cout << fixed << setprecision(2);
+        for (auto& [name, latencies] : {pair<string, vector<double>&>{"mutex", legacy_latency}, {"lock-free", stealing_latency}}) {
+            cout << left << setw(28) << (to_string(producers) + ", " + name)
+                 << setw(12) << percentile_us(latencies, 0.5)
+                 << setw(12) << percentile_us(latencies, 0.99)
+                 << setw(12) << percentile_us(latencies, 0.999) << endl;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,230 @@
+#ifndef _TOPOLOGY_HPP_
+#define _TOPOLOGY_HPP_
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <algorithm>
+#include <sched.h>
+
+using namespace std;
+
+/*
+    * Topologia das CPUs da máquina, lida do sysfs (/sys/devices/system).
+    *
+    * Para cada CPU que o processo pode usar (máscara de afinidade), guarda o núcleo físico, o soquete e o nó NUMA.
+    * É usada para fixar (pin) as threads do pool em núcleos e para saber em qual nó NUMA cada thread roda.
+    * Se o sysfs não estiver disponível, todas as CPUs ficam no nó 0, cada uma em seu próprio núcleo.
+*/
+class CpuTopology {
+    public:
+        struct Cpu {
+            int id;
+            int core;
+            int package;
+            int node;
+        };
+
+    private:
+        // CPUs que o processo pode usar
+        vector<Cpu> cpus;
+
+        // Quantidade de nós NUMA com pelo menos uma CPU usável
+        int nodes = 1;
+
+        // Lê um inteiro de um arquivo do sysfs (ou `fallback`, se o arquivo não existir)
+        static int read_int(const string& path, int fallback) {
+            ifstream file(path);
+            int value;
+            return (file >> value) ? value : fallback;
+        }
+
+        /*
+            * Lê uma lista de CPUs no formato do sysfs (ex.: "0-3,8-11").
+            * @param path Caminho do arquivo
+            * @returns: CPUs da lista (vazio se o arquivo não existir)
+        */
+        static vector<int> read_cpu_list(const string& path) {
+            vector<int> list;
+            ifstream file(path);
+            string text;
+            if (!getline(file, text)) return list;
+
+            stringstream ss(text);
+            string range;
+            while (getline(ss, range, ',')) {
+                if (range.empty()) continue;
+                size_t dash = range.find('-');
+                int first = atoi(range.substr(0, dash).c_str());
+                int last = dash == string::npos ? first : atoi(range.substr(dash + 1).c_str());
+                for (int cpu = first; cpu <= last; cpu++) list.push_back(cpu);
+            }
+            return list;
+        }
+
+        CpuTopology() {
+            cpu_set_t mask;
+            CPU_ZERO(&mask);
+            bool has_mask = sched_getaffinity(0, sizeof(mask), &mask) == 0;
+
+            const string base = "/sys/devices/system/cpu/cpu";
+            for (int id = 0; id < CPU_SETSIZE; id++) {
+                if (has_mask ? !CPU_ISSET(id, &mask) : id > 0) continue;
+
+                string topology = base + to_string(id) + "/topology/";
+                cpus.push_back({id, read_int(topology + "core_id", id), read_int(topology + "physical_package_id", 0), 0});
+            }
+
+            // Nó NUMA de cada CPU, pelas listas de CPUs de cada nó
+            for (int node = 0; node < 1024; node++) {
+                vector<int> list = read_cpu_list("/sys/devices/system/node/node" + to_string(node) + "/cpulist");
+                if (list.empty()) continue;
+                for (Cpu& cpu : cpus) {
+                    if (find(list.begin(), list.end(), cpu.id) != list.end()) cpu.node = node;
+                }
+            }
+
+            // Renumera os nós usados como 0..nodes-1, para poderem indexar vetores
+            vector<int> used;
+            for (const Cpu& cpu : cpus) used.push_back(cpu.node);
+            sort(used.begin(), used.end());
+            used.erase(unique(used.begin(), used.end()), used.end());
+            for (Cpu& cpu : cpus) cpu.node = lower_bound(used.begin(), used.end(), cpu.node) - used.begin();
+            nodes = max(1, (int) used.size());
+        }
+
+    public:
+        // Instância única, lida do sysfs na primeira chamada
+        static const CpuTopology& instance() {
+            static CpuTopology topology;
+            return topology;
+        }
+
+        // Quantidade de nós NUMA usáveis
+        int node_count() const {
+            return nodes;
+        }
+
+        // CPUs que o processo pode usar
+        const vector<Cpu>& available_cpus() const {
+            return cpus;
+        }
+
+        /*
+            * Retorna o nó NUMA (renumerado) de uma CPU.
+            * @param cpu Número da CPU
+            * @returns: nó da CPU, ou 0 se ela não estiver na máscara de afinidade
+        */
+        int node_of(int cpu) const {
+            for (const Cpu& c : cpus) {
+                if (c.id == cpu) return c.node;
+            }
+            return 0;
+        }
+
+        /*
+            * Ordem em que as threads do pool são fixadas nas CPUs.
+            * Primeiro uma CPU por núcleo físico, e só depois os irmãos de hyper-threading; dentro disso, nó por nó,
+            * para que threads vizinhas fiquem no mesmo nó e dividam as mesmas faixas da imagem.
+            * @returns: números das CPUs, na ordem de uso
+        */
+        vector<int> placement() const {
+            vector<Cpu> order = cpus;
+            vector<int> sibling(order.size(), 0);
+
+            // Posição de cada CPU entre as CPUs do mesmo núcleo físico (0 para a primeira)
+            for (size_t i = 0; i < order.size(); i++) {
+                for (size_t j = 0; j < i; j++) {
+                    if (order[j].package == order[i].package && order[j].core == order[i].core) sibling[i]++;
+                }
+            }
+
+            vector<size_t> index(order.size());
+            for (size_t i = 0; i < index.size(); i++) index[i] = i;
+            stable_sort(index.begin(), index.end(), [&](size_t a, size_t b) {
+                if (sibling[a] != sibling[b]) return sibling[a] < sibling[b];
+                return order[a].node < order[b].node;
+            });
+
+            vector<int> result;
+            for (size_t i : index) result.push_back(order[i].id);
+            return result;
+        }
+};
+
+/*
+    * Lê o limite de CPU do cgroup v2 do processo (arquivo cpu.max, "cota período" ou "max período").
+    * Percorre o cgroup do processo e os cgroups acima dele, pois o limite efetivo é o menor de todos.
+    * @returns: quantidade de CPUs permitida pela cota (arredondada para cima), ou 0 se não houver limite
+*/
+inline int cgroup_cpu_limit() {
+    ifstream cgroup("/proc/self/cgroup");
+    string line, path;
+    while (getline(cgroup, line)) {
+        // No cgroup v2 há uma única hierarquia, na linha "0::/caminho"
+        if (line.rfind("0::", 0) == 0) path = line.substr(3);
+    }
+    if (path.empty()) return 0;
+
+    int limit = 0;
+    while (true) {
+        ifstream file("/sys/fs/cgroup" + (path == "/" ? string() : path) + "/cpu.max");
+        string quota;
+        long long period = 0;
+        if (file >> quota >> period && quota != "max" && period > 0) {
+            long long cpus = (atoll(quota.c_str()) + period - 1) / period;
+            int value = (int) max(1LL, cpus);
+            limit = limit == 0 ? value : min(limit, value);
+        }
+
+        if (path == "/" || path.empty()) break;
+        size_t slash = path.find_last_of('/');
+        path = slash == 0 ? "/" : path.substr(0, slash);
+    }
+    return limit;
+}
+
+/*
+    * Quantidade de CPUs que o processo pode usar de fato: as CPUs da máscara de afinidade,
+    * limitadas pela cota de CPU do cgroup v2 (ex.: em um container com 4 CPUs, 4, mesmo que a máquina tenha 64).
+    * @returns: quantidade de CPUs (pelo menos 1)
+*/
+inline int effective_cpu_count() {
+    int cpus = CpuTopology::instance().available_cpus().size();
+    int limit = cgroup_cpu_limit();
+    if (limit > 0) cpus = min(cpus, limit);
+    return max(1, cpus);
+}
+
+/*
+    * Tamanho do maior cache da CPU 0 (normalmente o último nível, L3), lido do sysfs (ex.: "32768K").
+    * @returns: tamanho em bytes, ou 0 se o sysfs não estiver disponível
+*/
+inline size_t last_level_cache_bytes() {
+    size_t largest = 0;
+    for (int index = 0; index < 16; index++) {
+        ifstream file("/sys/devices/system/cpu/cpu0/cache/index" + to_string(index) + "/size");
+        string text;
+        if (!(file >> text)) continue;
+
+        size_t size = strtoull(text.c_str(), nullptr, 10);
+        char unit = text.back();
+        if (unit == 'K') size <<= 10;
+        else if (unit == 'M') size <<= 20;
+        largest = max(largest, size);
+    }
+    return largest;
+}
+
+/*
+    * Indica se as threads do pool devem ser fixadas em núcleos, pela variável de ambiente PIN_THREADS (1 para fixar).
+    * @returns: true se PIN_THREADS=1
+*/
+inline bool pin_threads_from_env() {
+    const char* value = getenv("PIN_THREADS");
+    return value != nullptr && string(value) == "1";
+}
+
+#endif // _TOPOLOGY_HPP_
@@ -0,0 +1,72 @@
+#ifndef _TRAVERSAL_HPP_
+#define _TRAVERSAL_HPP_
+
+#include <algorithm>
+#include "region.hpp"
+#include "cancellation.hpp"
+
+using namespace std;
+
+/*
+    * Camada de percurso usada pelos filtros.
+    *
+    * A imagem é guardada linha a linha na memória, então os filtros devem percorrer a região
+    * com as linhas no laço de fora e as colunas no laço de dentro, acessando os pixels por ponteiros
+    * de linha (`Mat::ptr`) ao invés de `Mat::at` a cada pixel. Assim cada passo do laço interno
+    * lê o byte seguinte da memória, ao invés de pular uma linha inteira.
+    *
+    * Antes de cada linha, os percursos conferem se o job da tarefa atual foi cancelado, e param se foi.
+*/
+
+/*
+    * Percorre as linhas da região, de cima para baixo.
+    * @param region Região da imagem a ser processada
+    * @param row_fn Função chamada como `row_fn(y, x_begin, x_end)` para cada linha y da região
+    * @returns: void
+*/
+template <typename RowFn>
+inline void for_each_row(const Region& region, RowFn row_fn) {
+    for (int y = region.y_begin; y <= region.y_end; y++) {
+        if (CancellationToken::requested()) return;
+        row_fn(y, region.x_begin, region.x_end);
+    }
+}
+
+/*
+    * Percorre as linhas da região separando, em cada linha, os trechos de interior e de borda
+    * para uma vizinhança de raio `radius`.
+    *
+    * No interior a vizinhança inteira está dentro da imagem, então o filtro não precisa testar os limites
+    * a cada vizinho. Na borda parte da vizinhança cai fora da imagem e os testes são necessários.
+    * Os trechos são passados com limites inclusivos, na ordem em que aparecem na linha.
+    *
+    * @param region Região da imagem a ser processada
+    * @param radius Raio da vizinhança usada pelo filtro
+    * @param width Largura da imagem
+    * @param height Altura da imagem
+    * @param interior_fn Função chamada como `interior_fn(y, x_begin, x_end)` para os trechos de interior
+    * @param border_fn Função chamada como `border_fn(y, x_begin, x_end)` para os trechos de borda
+    * @returns: void
+*/
+template <typename InteriorFn, typename BorderFn>
+inline void for_each_row_split(const Region& region, int radius, int width, int height, InteriorFn interior_fn, BorderFn border_fn) {
+    // colunas cuja vizinhança horizontal cabe inteira na imagem
+    const int inner_begin = max(region.x_begin, radius);
+    const int inner_end = min(region.x_end, width - 1 - radius);
+
+    for (int y = region.y_begin; y <= region.y_end; y++) {
+        if (CancellationToken::requested()) return;
+
+        // linha perto do topo ou do fundo da imagem: a linha inteira é borda
+        if (y - radius < 0 || y + radius >= height || inner_begin > inner_end) {
+            border_fn(y, region.x_begin, region.x_end);
+            continue;
+        }
+
+        if (region.x_begin < inner_begin) border_fn(y, region.x_begin, inner_begin - 1);
+        interior_fn(y, inner_begin, inner_end);
+        if (inner_end < region.x_end) border_fn(y, inner_end + 1, region.x_end);
+    }
+}
+
+#endif // _TRAVERSAL_HPP_
@@ -0,0 +1,124 @@
+#ifndef _WAIT_GROUP_HPP_
+#define _WAIT_GROUP_HPP_
+
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+
+using namespace std;
+
+/*
+    * Classe WaitGroup
+    *
+    * Contador de tarefas pendentes de um job (como um latch): cada tarefa chama `done()` ao terminar.
+    * Quando o contador chega a zero, as continuações registradas com `then()` são executadas (pela thread
+    * que fez o último `done()`) e as threads esperando em `wait()` são acordadas.
+    *
+    * Substitui contadores comuns incrementados por várias threads, que não são seguros, e a consulta
+    * periódica (polling) de booleanos para saber se um job terminou.
+*/
+class WaitGroup {
+    private:
+        // Quantidade de tarefas que ainda não chamaram `done()`
+        atomic<int> count;
+
+        // Protege as continuações e é usado pela variável de condição das threads em `wait()`
+        mutex mtx;
+        condition_variable cond_var;
+
+        // Continuações a executar quando o contador chegar a zero
+        vector<function<void()>> continuations;
+
+        // Se o contador já chegou a zero (protegido por `mtx`)
+        bool finished;
+
+    public:
+        /*
+            * Construtor da classe WaitGroup.
+            * @param count Quantidade inicial de tarefas pendentes
+        */
+        explicit WaitGroup(int count = 0) : count(count), finished(count <= 0) {}
+
+        WaitGroup(const WaitGroup&) = delete;
+        WaitGroup& operator=(const WaitGroup&) = delete;
+
+        /*
+            * Adiciona tarefas pendentes. Deve ser chamada antes de o contador chegar a zero.
+            * @param n Quantidade de tarefas a adicionar
+        */
+        void add(int n = 1) {
+            lock_guard<mutex> lock(mtx);
+            count.fetch_add(n, memory_order_relaxed);
+            finished = false;
+        }
+
+        /*
+            * Marca uma tarefa como concluída. A última tarefa executa as continuações e acorda quem estiver esperando.
+            * Quem espera só acorda depois das continuações, para já ver o que elas registraram (ex.: o timer parado).
+        */
+        void done() {
+            if (count.fetch_sub(1, memory_order_acq_rel) != 1) return;
+
+            while (true) {
+                vector<function<void()>> to_run;
+                {
+                    lock_guard<mutex> lock(mtx);
+                    // Sem continuações pendentes (nem registradas enquanto as anteriores rodavam): marca como concluído
+                    if (continuations.empty()) {
+                        finished = true;
+                        break;
+                    }
+                    to_run.swap(continuations);
+                }
+
+                for (auto& continuation : to_run) continuation();
+            }
+            cond_var.notify_all();
+        }
+
+        /*
+            * Registra uma continuação para quando todas as tarefas terminarem.
+            * Se elas já tiverem terminado, a continuação é executada imediatamente, pela thread atual.
+            * @param continuation Função a executar
+        */
+        void then(function<void()> continuation) {
+            {
+                lock_guard<mutex> lock(mtx);
+                if (!finished) {
+                    continuations.push_back(move(continuation));
+                    return;
+                }
+            }
+            continuation();
+        }
+
+        /*
+            * Bloqueia a thread atual até que todas as tarefas terminem.
+        */
+        void wait() {
+            unique_lock<mutex> lock(mtx);
+            cond_var.wait(lock, [this] { return finished; });
+        }
+
+        /*
+            * Bloqueia a thread atual até que todas as tarefas terminem ou até o tempo limite.
+            * @param timeout Tempo máximo de espera
+            * @return true se todas as tarefas terminaram
+        */
+        template <typename Rep, typename Period>
+        bool wait_for(const chrono::duration<Rep, Period>& timeout) {
+            unique_lock<mutex> lock(mtx);
+            return cond_var.wait_for(lock, timeout, [this] { return finished; });
+        }
+
+        // Retorna se todas as tarefas já terminaram
+        bool is_done() {
+            lock_guard<mutex> lock(mtx);
+            return finished;
+        }
+};
+
+#endif // _WAIT_GROUP_HPP_
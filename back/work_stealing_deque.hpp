@@ -0,0 +1,137 @@
+#ifndef _WORK_STEALING_DEQUE_HPP_
+#define _WORK_STEALING_DEQUE_HPP_
+
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+using namespace std;
+
+/*
+    * Deque de Chase-Lev, usada por cada thread do pool para guardar as próprias tarefas.
+    *
+    * Apenas a thread dona chama `push` e `pop`, que trabalham no fundo (bottom) da deque, em ordem LIFO
+    * (a tarefa mais recente ainda está no cache). As outras threads chamam `steal`, que retira do topo (top),
+    * em ordem FIFO. Dono e ladrões só disputam (via compare-and-swap) quando resta um único elemento.
+    *
+    * O buffer é circular e dobra de tamanho quando enche. Os buffers antigos são mantidos até a deque ser destruída,
+    * pois um ladrão atrasado pode ainda estar lendo deles.
+    *
+    * Implementação baseada em "Correct and Efficient Work-Stealing for Weak Memory Models" (Lê et al., 2013).
+*/
+template <typename T>
+class WorkStealingDeque {
+    private:
+        // Buffer circular com capacidade potência de 2
+        struct Buffer {
+            int64_t capacity;
+            int64_t mask;
+            unique_ptr<atomic<T*>[]> items;
+
+            explicit Buffer(int64_t capacity) : capacity(capacity), mask(capacity - 1), items(new atomic<T*>[capacity]) {}
+
+            T* get(int64_t i) const { return items[i & mask].load(memory_order_relaxed); }
+            void put(int64_t i, T* item) { items[i & mask].store(item, memory_order_relaxed); }
+        };
+
+        // Índices do topo (onde os ladrões retiram) e do fundo (onde o dono insere e retira)
+        alignas(64) atomic<int64_t> top;
+        alignas(64) atomic<int64_t> bottom;
+
+        // Buffer atual e os buffers antigos, liberados apenas no destrutor
+        atomic<Buffer*> buffer;
+        vector<unique_ptr<Buffer>> buffers;
+
+        // Dobra a capacidade do buffer, copiando os elementos entre top e bottom
+        Buffer* grow(Buffer* old, int64_t t, int64_t b) {
+            buffers.push_back(make_unique<Buffer>(old->capacity * 2));
+            Buffer* bigger = buffers.back().get();
+            for (int64_t i = t; i < b; i++) bigger->put(i, old->get(i));
+            buffer.store(bigger, memory_order_release);
+            return bigger;
+        }
+
+    public:
+        explicit WorkStealingDeque(int64_t capacity = 256) : top(0), bottom(0) {
+            buffers.push_back(make_unique<Buffer>(capacity));
+            buffer.store(buffers.back().get(), memory_order_relaxed);
+        }
+
+        WorkStealingDeque(const WorkStealingDeque&) = delete;
+        WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+        /*
+            * Insere uma tarefa no fundo da deque. Só pode ser chamada pela thread dona.
+            * @param item Tarefa a ser inserida
+        */
+        void push(T* item) {
+            int64_t b = bottom.load(memory_order_relaxed);
+            int64_t t = top.load(memory_order_acquire);
+            Buffer* a = buffer.load(memory_order_relaxed);
+
+            if (b - t > a->capacity - 1) {
+                a = grow(a, t, b);
+            }
+
+            a->put(b, item);
+            atomic_thread_fence(memory_order_release);
+            bottom.store(b + 1, memory_order_relaxed);
+        }
+
+        /*
+            * Retira a tarefa mais recente do fundo da deque. Só pode ser chamada pela thread dona.
+            * @return a tarefa, ou nullptr se a deque estiver vazia (ou se um ladrão levou o último elemento)
+        */
+        T* pop() {
+            int64_t b = bottom.load(memory_order_relaxed) - 1;
+            Buffer* a = buffer.load(memory_order_relaxed);
+            bottom.store(b, memory_order_relaxed);
+            atomic_thread_fence(memory_order_seq_cst);
+            int64_t t = top.load(memory_order_relaxed);
+
+            T* item = nullptr;
+            if (t <= b) {
+                item = a->get(b);
+                if (t == b) {
+                    // Último elemento: disputa com os ladrões
+                    if (!top.compare_exchange_strong(t, t + 1, memory_order_seq_cst, memory_order_relaxed)) {
+                        item = nullptr;
+                    }
+                    bottom.store(b + 1, memory_order_relaxed);
+                }
+            } else {
+                bottom.store(b + 1, memory_order_relaxed);
+            }
+            return item;
+        }
+
+        /*
+            * Retira a tarefa mais antiga do topo da deque. Pode ser chamada por qualquer thread.
+            * @return a tarefa, ou nullptr se a deque estiver vazia ou se outra thread levou o elemento antes
+        */
+        T* steal() {
+            int64_t t = top.load(memory_order_acquire);
+            atomic_thread_fence(memory_order_seq_cst);
+            int64_t b = bottom.load(memory_order_acquire);
+
+            if (t < b) {
+                Buffer* a = buffer.load(memory_order_acquire);
+                T* item = a->get(t);
+                if (!top.compare_exchange_strong(t, t + 1, memory_order_seq_cst, memory_order_relaxed)) {
+                    return nullptr;
+                }
+                return item;
+            }
+            return nullptr;
+        }
+
+        // Quantidade aproximada de elementos (pode estar desatualizada se houver acessos concorrentes)
+        int64_t size() const {
+            int64_t b = bottom.load(memory_order_relaxed);
+            int64_t t = top.load(memory_order_relaxed);
+            return b > t ? b - t : 0;
+        }
+};
+
+#endif // _WORK_STEALING_DEQUE_HPP_
@@ -34,6 +34,21 @@ var stopState = {
 var multi_thread_image_link = null;
 var single_thread_image_link = null;
 
+// Número do job do último processamento pedido, retornado pelo backend e usado para buscar as imagens processadas
+var job_id = 0;
+// Token do último job, exigido pelo backend junto com o número para consultá-lo e para cancelá-lo quando um novo processamento o substitui
+var job_token = "";
+
+// Parâmetros que identificam o job atual nas consultas ao backend
+function jobQuery() {
+    return "jobId=" + job_id + "&jobToken=" + encodeURIComponent(job_token);
+}
+
+// Handle da imagem já enviada ao backend (/images) e o arquivo correspondente: processar de novo a mesma imagem
+// (outro filtro, outra intensidade) não a envia outra vez
+var image_handle = null;
+var handle_file = null;
+
 // EVENTOS
 
 // Para arrastar arquivso a para dentro do input
@@ -135,34 +150,79 @@ function input_process() {
         stopProcess();
 }
 
-// Função que chama a filtragem em si
-function process(){
-    let file = picker.files[0];
-    let type = file.name.split(".")[1];
+// Envia a imagem ao backend, se ainda não foi enviada, e retorna o handle dela
+function uploadImage(file) {
+    if (file === handle_file && image_handle != null) return Promise.resolve(image_handle);
 
-    // Junta os dados da imagem e das opções escolhidas em um FormData para enviar para o backend
     const formData = new FormData();
     formData.append("image", file);
+    return fetch("/images", {
+        method: "POST",
+        body: formData,
+    })
+    .then((response) => response.json())
+    .then((data) => {
+        image_handle = data.handle;
+        handle_file = file;
+        return image_handle;
+    });
+}
+
+// Pede o processamento da imagem já enviada, com as opções escolhidas
+function sendProcess(handle, type) {
+    const formData = new FormData();
+    formData.append("imageHandle", handle);
     formData.append("intensity", intensity.value);
     formData.append("qtdThreads", thread_sel.innerHTML);
     formData.append("filter", filter_sel.innerHTML);
     formData.append("colorOption", color_sel);
     formData.append("filetype", type);
+    // O job anterior deste usuário, se ainda estiver rodando, é cancelado
+    formData.append("replaces", job_id);
+    formData.append("replacesToken", job_token);
+    // O usuário está esperando o resultado na tela: as tarefas passam na frente dos processamentos em lote
+    formData.append("priority", "interactive");
 
-    fetch("/process", {
+    return fetch("/process", {
         method: "POST",
         body: formData,
-        
+    });
+}
+
+// Função que chama a filtragem em si
+function process(){
+    let file = picker.files[0];
+    let type = file.name.split(".")[1];
+
+    uploadImage(file)
+    .then((handle) => sendProcess(handle, type))
+    .then((response) => {
+        // O backend descartou a imagem da memória: envia de novo e repete o pedido
+        if (response.status == 404) {
+            image_handle = null;
+            return uploadImage(file).then((handle) => sendProcess(handle, type));
+        }
+        return response;
+    })
+    .then((response) => {
+        // Todas as vagas de jobs do backend estão ocupadas: o botão continua liberado para tentar de novo
+        if (response.status == 503) {
+            alert("Server busy, try again in a few seconds.");
+            return null;
+        }
+        return response.json();
     })
-    .then((response) => response.json())
     .then((data) => {
+        if (!data) return;
+        job_id = data.jobId;
+        job_token = data.jobToken;
+
         // Coloca o estado de processamento como false para que o botão de processar fique desabilitado
         stopState.mult = false;
         stopState.single = false;
         checkProcess();
 
-        gettingImage_MultiThread(200);
-        gettingImage_SingleThread(200);
+        listenProcess();
     })
 }
 
@@ -185,7 +245,7 @@ window.onload = () => {
     .then((response) => response.json())
     .then((data) => {
         options = [];
-        for(let i = 2; i <= Number(data.maxThreads); i++){
+        for(let i = Math.min(2, Number(data.maxThreads)); i <= Number(data.maxThreads); i++){
             options.push(i);
         }
         fillDropdown(thread_dd, options, thread_sel);
@@ -200,57 +260,169 @@ window.onload = () => {
     intensity.value = 5;
 };
 
-function gettingImage_SingleThread(seconds) {
-    // Essa funcao vai atualizando as imagens a cada x milissegundos, consultando o servidor para pegar uma versão atualizada
-    // Isso mostra o progresso do processamento
-    setTimeout(() => {
-        fetch("/getSingleThreadImage")
-        .then((response) => {
-            const done = response.headers.get("done");
-            const duration = response.headers.get("duration");
-            return response.blob().then(blob => ({ blob, done, duration }));
-        })
-        .then(({blob, done, duration}) => {
-            // Aqui, a imagem é atualizada conforme o processamento avança e o tempo de processamento corrente é mostrado
-            single_thread_image.src = URL.createObjectURL(blob);
-            single_thread_image_link = single_thread_image.src;
-            single_thread_duration.innerHTML = Number(duration).toLocaleString('de-DE', { minimumFractionDigits: 1, maximumFractionDigits: 1 }) + " ms";
-            
-            // Se o processamento estiver completo, a função de atualização é parada e o estado de processamento para a imagem singlethread é atualizado
-            // Tão como a imagem em si
-            if(done == "1") {
-                stopState.single = true;
-                checkProcess();
-            }else{
-                gettingImage_SingleThread(seconds);
-            }
-        })
-    }, seconds);
+// Estado do acompanhamento de cada saída: um canvas fora da tela com a imagem parcial, montada com os blocos recebidos,
+// o número de sequência da última consulta, se há uma consulta em andamento (ou outra pedida enquanto isso) e se a saída terminou
+const progress = {
+    single : { canvas : document.createElement("canvas"), sequence : 0, fetching : false, again : false, done : false,
+               endpoint : "/getSingleThreadImage", image : single_thread_image, duration : single_thread_duration },
+    multi  : { canvas : document.createElement("canvas"), sequence : 0, fetching : false, again : false, done : false,
+               endpoint : "/getMultiThreadImage", image : multi_thread_image, duration : multi_thread_duration },
+};
+
+// Conexão de eventos (Server-Sent Events) do job atual
+var events = null;
+
+// Acompanha o job atual pelos eventos do servidor, em vez de consultar de tempos em tempos
+// A cada evento de progresso, busca só os blocos que mudaram; quando uma saída fica pronta, busca a imagem dela uma única vez
+function listenProcess() {
+    if (events) events.close();
+    resetProgress("single");
+    resetProgress("multi");
+
+    events = new EventSource("/events?" + jobQuery());
+    events.addEventListener("progress", (e) => {
+        const data = JSON.parse(e.data);
+        showDuration(progress[data.output], data.duration);
+        refreshProgress(data.output);
+    });
+    events.addEventListener("ready", (e) => {
+        const data = JSON.parse(e.data);
+        finishOutput(data.output, data.duration);
+
+        // As duas saídas prontas: fecha a conexão antes que o servidor a encerre (senão o navegador reconecta)
+        if (progress.single.done && progress.multi.done) events.close();
+    });
+    events.addEventListener("cancelled", () => {
+        events.close();
+        stopWaiting();
+    });
+
+    // Conexão recusada ou encerrada pelo servidor (muitas conexões de eventos abertas, ou job descartado):
+    // acompanha as saídas por consultas longas. Se a conexão só caiu, o navegador reconecta sozinho
+    const id = job_id;
+    events.onerror = () => {
+        if (events.readyState != EventSource.CLOSED) return;
+        pollOutput("single", id);
+        pollOutput("multi", id);
+    };
+}
+
+// O job não vai mais terminar (cancelado ou descartado pelo servidor): libera o botão de processar
+function stopWaiting() {
+    stopState.single = true;
+    stopState.mult = true;
+    checkProcess();
+}
+
+// Espera uma saída do job `id` terminar, com consultas que o servidor segura até ela terminar (ou por até 5 segundos)
+// Enquanto ela não termina, o servidor responde 204, sem a imagem: atualiza o progresso e consulta de novo um pouco depois
+// (se o servidor estiver sem conexões livres, ele responde na hora, e o intervalo evita consultas seguidas)
+function pollOutput(output, id) {
+    const state = progress[output];
+    if (state.done || id != job_id) return;
+
+    fetch(state.endpoint + "?" + jobQuery() + "&wait=5000")
+    .then((response) => {
+        if (state.done || id != job_id) return;
+        if (!response.ok) {
+            stopWaiting();
+            return;
+        }
+        if (response.status == 200 && response.headers.get("done") == "1") {
+            state.done = true;
+            showDuration(state, response.headers.get("duration"));
+            return response.blob().then((blob) => showOutput(output, blob));
+        }
+        showDuration(state, response.headers.get("duration"));
+        refreshProgress(output);
+        setTimeout(() => pollOutput(output, id), 500);
+    });
 }
 
-function gettingImage_MultiThread(seconds) {
-    // O mesmo que a função acima, mas para o processamento multithread
-    setTimeout(() => {
-        fetch("/getMultiThreadImage")
-        .then((response) => {
-            const done = response.headers.get("done");
-            const duration = response.headers.get("duration");
-            return response.blob().then(blob => ({ blob, done, duration }));
-        })
-        .then(({blob, done, duration}) => {
-            // Update da imagem e do tempo de processamento
-            multi_thread_image.src = URL.createObjectURL(blob);
-            multi_thread_image_link = multi_thread_image.src;
-            multi_thread_duration.innerHTML = Number(duration).toLocaleString('de-DE', { minimumFractionDigits: 1, maximumFractionDigits: 1 }) + " ms";
-            
-            // Se o processamento estiver completo, a função de atualização é parada e o estado de processamento para a imagem multithread é atualizado
-            // Tão como a imagem em si
-            if(done == "1") {
-                stopState.mult = true;
-                checkProcess();
-            }else{
-                gettingImage_MultiThread(seconds);
+// Recomeça o acompanhamento de uma saída (novo processamento)
+function resetProgress(output) {
+    const state = progress[output];
+    state.sequence = 0;
+    state.again = false;
+    state.done = false;
+    state.canvas.width = 0;
+}
+
+function showDuration(state, duration) {
+    state.duration.innerHTML = Number(duration).toLocaleString('de-DE', { minimumFractionDigits: 1, maximumFractionDigits: 1 }) + " ms";
+}
+
+// Busca os blocos de uma saída que mudaram desde a última consulta, desenha-os no canvas e mostra o canvas na imagem
+// Só uma consulta por saída fica em andamento; eventos que chegam nesse meio tempo geram uma única consulta depois dela
+function refreshProgress(output) {
+    const state = progress[output];
+    if (state.fetching) {
+        state.again = true;
+        return;
+    }
+    state.fetching = true;
+    state.again = false;
+
+    fetch("/getProgress?" + jobQuery() + "&output=" + output + "&since=" + state.sequence)
+    .then((response) => response.json())
+    .then((data) => {
+        const ctx = state.canvas.getContext("2d");
+        if (state.canvas.width != data.width || state.canvas.height != data.height) {
+            // Saída nova: começa preta, como a do servidor
+            state.canvas.width = data.width;
+            state.canvas.height = data.height;
+            ctx.fillStyle = "black";
+            ctx.fillRect(0, 0, data.width, data.height);
+        }
+
+        // Desenha cada bloco na sua posição
+        const drawn = data.tiles.map((tile) => new Promise((resolve) => {
+            const img = new Image();
+            img.onload = () => { ctx.drawImage(img, tile.x, tile.y); resolve(); };
+            img.onerror = resolve;
+            img.src = "data:image/png;base64," + tile.png;
+        }));
+
+        return Promise.all(drawn).then(() => {
+            state.sequence = data.sequence;
+            if (!state.done && data.tiles.length > 0) {
+                state.canvas.toBlob((blob) => { if (!state.done) state.image.src = URL.createObjectURL(blob); });
             }
-        })
-    }, seconds);
-}
\ No newline at end of file
+        });
+    })
+    .finally(() => {
+        state.fetching = false;
+        if (state.again && !state.done) refreshProgress(output);
+    });
+}
+
+// Saída concluída: busca a imagem final, no formato original, uma única vez (para a imagem e o download)
+function finishOutput(output, duration) {
+    const state = progress[output];
+    state.done = true;
+    showDuration(state, duration);
+
+    fetch(state.endpoint + "?" + jobQuery())
+    .then((response) => {
+        // Job descartado pelo servidor antes de a imagem ser buscada
+        if (!response.ok) {
+            stopWaiting();
+            return;
+        }
+        return response.blob().then((blob) => showOutput(output, blob));
+    });
+}
+
+// Mostra a imagem final de uma saída e libera o botão de processar se as duas terminaram
+function showOutput(output, blob) {
+    const state = progress[output];
+    state.image.src = URL.createObjectURL(blob);
+    if (output == "single") {
+        single_thread_image_link = state.image.src;
+        stopState.single = true;
+    } else {
+        multi_thread_image_link = state.image.src;
+        stopState.mult = true;
+    }
+    checkProcess();
+}